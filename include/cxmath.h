@@ -0,0 +1,55 @@
+// Maths for C++14 constexpr functions, so tables can be calculated by the compiler & stored in flash.
+// Only +, -, * & / are used, so the results are the same on every compiler (& in the Python tools that mirror them)
+#ifndef CXMATH_H
+#define CXMATH_H
+
+#include <stdint.h>
+
+constexpr double CxExp(double x) // exp(x) - halve x until small, Taylor series, then square back up
+{
+  uint8_t halvings = 0;
+  while (x > 0.5 || x < -0.5)
+  {
+    x /= 2;
+    halvings++;
+  }
+  double term = 1, sum = 1;
+  for (uint8_t i = 1; i < 20; i++)
+  {
+    term *= x / i;
+    sum += term;
+  }
+  while (halvings--) sum *= sum;
+  return sum;
+}
+
+constexpr double CxSqrt(double x) // Newton's method
+{
+  double r = x > 1 ? x : 1;
+  for (uint8_t i = 0; i < 60; i++) r = (r + x / r) / 2;
+  return r;
+}
+
+constexpr double CxSin(double x) // Taylor series - for 0 to pi
+{
+  double term = x, sum = x;
+  for (uint8_t i = 1; i < 15; i++)
+  {
+    term *= -x * x / ((2 * i) * (2 * i + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double CxCos(double x) // for 0 to pi
+{
+  double term = 1, sum = 1;
+  for (uint8_t i = 1; i < 15; i++)
+  {
+    term *= -x * x / ((2 * i - 1) * (2 * i));
+    sum += term;
+  }
+  return sum;
+}
+
+#endif // CXMATH_H
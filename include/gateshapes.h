@@ -0,0 +1,62 @@
+// Gate shapes for the sound envelope (SetGate() & StartGate()) - calculated by the compiler & stored in flash, so
+// they cost no RAM & no time at start-up. Each table is a rise, silent to full, in Q15 (32768 = full level) with
+// GATE_POINTS + 1 points, so linear interpolation needs no test at the top. A fall plays its table backwards.
+// Rise & fall shapes are chosen independently. The half Hann window & the raised-cosine (Tukey) taper are the same
+// curve as cos^2, so they're names for it. Other lengths can be made with MakeGateShape<N>().
+#ifndef GATESHAPES_H
+#define GATESHAPES_H
+
+#include <stdint.h>
+#include "cxmath.h"
+
+#define GATE_POINTS   1024  // points per shape (+ 1) - GateBlock() reads them with a 32 bit position (4194304 = 2^32 / 1024)
+
+#define GATE_LINEAR   0     // straight line
+#define GATE_COSINE   1     // quarter sine (0 to 90 degrees)
+#define GATE_COS2     2     // cos^2 (sine squared) - no step in slope at either end. Read backwards it's the old costable.h (0.5 + 0.5 cos, 0 to 180 degrees)
+#define GATE_HANN     GATE_COS2
+#define GATE_RAISED_COSINE GATE_COS2
+#define GATE_BLACKMAN 3     // half Blackman window - slower start & finish, lower spectral splatter than cos^2
+#define GATE_SHAPES   4
+
+constexpr double GateShapeLevel(uint8_t shape, double x) // level (0 to 1) of a shape at x (0 to 1) through the rise
+{
+  return shape == GATE_LINEAR   ? x
+       : shape == GATE_COSINE   ? CxSin(1.5707963267948966 * x)
+       : shape == GATE_COS2     ? CxSin(1.5707963267948966 * x) * CxSin(1.5707963267948966 * x)
+       : 0.42 - 0.5 * CxCos(3.141592653589793 * x) + 0.08 * (2 * CxCos(3.141592653589793 * x) * CxCos(3.141592653589793 * x) - 1); // (cos 2a = 2 cos^2 a - 1, as CxCos only covers 0 to pi)
+}
+
+template <uint16_t N> struct GateShapeTable
+{
+  uint16_t v[N + 1];
+};
+
+template <uint16_t N> constexpr GateShapeTable<N> MakeGateShape(uint8_t shape)
+{
+  GateShapeTable<N> t = {};
+  for (uint16_t i = 0; i <= N; i++)
+  {
+    double q = GateShapeLevel(shape, (double) i / N) * 32768 + 0.5;
+    t.v[i] = q < 0 ? 0 : q > 32768 ? 32768 : (uint16_t) q;
+  }
+  t.v[0] = 0;
+  t.v[N] = 32768; // exactly silent & full at the ends, whatever the rounding
+  return t;
+}
+
+struct GateShapeSet
+{
+  GateShapeTable<GATE_POINTS> shape[GATE_SHAPES];
+};
+
+constexpr GateShapeSet MakeGateShapes()
+{
+  GateShapeSet s = {};
+  for (uint8_t k = 0; k < GATE_SHAPES; k++) s.shape[k] = MakeGateShape<GATE_POINTS>(k);
+  return s;
+}
+
+static constexpr GateShapeSet GateShapes = MakeGateShapes(); // 8 kBytes of flash - only in the files that read them (main.ino uses GateShapeRise())
+
+#endif // GATESHAPES_H
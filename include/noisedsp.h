@@ -0,0 +1,467 @@
+// Fixed-point noise colouring filter - plain C++ so it builds for both the Due & a host PC
+
+#ifndef NOISEDSP_H
+#define NOISEDSP_H
+
+#include <stdint.h>
+#include <math.h>
+#include "cxmath.h"
+#include "speakereq.h"
+
+#define NOISE_SECTIONS   6      // number of 1st order shelving sections in the colour filter
+#define NOISE_POLE0      150.0  // lowest pole freq (Hz) - the colour slope holds from about 2 x this freq upwards
+#define NOISE_POLE_RATIO 3.0    // freq ratio between poles (about 1.6 octaves)
+#define NOISE_LN_RATIO   1.0986122886681098 // natural log of NOISE_POLE_RATIO
+#define NOISE_RMS        600    // RMS level of the filtered noise in 12 bit DAC steps at full amplitude (white noise peaks at +/- 1040)
+#define NOISE_COLOURS    1001   // colour table entries: 0 (brown) to 1000 (white)
+#ifndef NOISE_DIVISOR
+#define NOISE_DIVISOR    280    // noise timer divisor (see TC_setup1): 280 = 150kHz, 105 = 400kHz (the same as the tone path, but the CPU load there is unmeasured - check nl first) - set per deployment with -D NOISE_DIVISOR= in platformio.ini
+#endif
+#define NOISE_RATE       (42000000.0 / NOISE_DIVISOR) // noise sample rate (Hz) the filter tables are made for
+static_assert(NOISE_DIVISOR >= 42, "the DAC can't convert faster than 1 MHz");
+
+struct NoisePoleCoefs // pole coefficients for NoiseColourFilter() - the same for every colour
+{
+  int32_t a[NOISE_SECTIONS];   // Q31
+};
+
+struct NoiseColourCoefs // colour coefficients for NoiseColourFilter() - 1 set per colour in NoiseColours
+{
+  int32_t gain;                // input gain - Q31
+  int32_t b[NOISE_SECTIONS];   // zero coefficients - Q31
+};
+
+struct NoiseBiquadCoefs // biquad coefficients - Q28 (range +/- 8)
+{
+  int32_t b0, b1, b2, a1, a2;
+};
+
+struct NoiseBiquadState
+{
+  int32_t x1, x2, y1, y2;
+};
+
+struct NoiseFilterState
+{
+  int32_t in;                  // previous filter input
+  int32_t y[NOISE_SECTIONS];   // previous output of each section
+};
+
+struct NoiseRng // seeded white noise generator for reproducible "frozen" noise
+{
+  uint32_t s[4];               // xoshiro128** state
+  uint32_t word;               // last 32 bit output - split into 2 x 16 bit samples
+  uint8_t  half;               // 1 when the upper 16 bits of word are still to be used
+};
+
+static inline uint32_t RotL32(uint32_t x, uint8_t k)
+{
+  return (x << k) | (x >> (32 - k));
+}
+
+static inline void NoiseRngSeed(NoiseRng *r, uint32_t seed) // fill the xoshiro128** state from a 32 bit seed with splitmix32 - every seed gives a different, non-zero state
+{
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    uint32_t z = (seed += 0x9E3779B9);
+    z = (z ^ (z >> 16)) * 0x85EBCA6B;
+    z = (z ^ (z >> 13)) * 0xC2B2AE35;
+    r->s[i] = z ^ (z >> 16);
+  }
+  r->half = 0;
+}
+
+static inline uint32_t NoiseRngNext(NoiseRng *r) // xoshiro128** - about 15 cycles on the Cortex-M3
+{
+  uint32_t result = RotL32(r->s[1] * 5, 7) * 9;
+  uint32_t t = r->s[1] << 9;
+  r->s[2] ^= r->s[0];
+  r->s[3] ^= r->s[1];
+  r->s[1] ^= r->s[2];
+  r->s[0] ^= r->s[3];
+  r->s[2] ^= t;
+  r->s[3] = RotL32(r->s[3], 11);
+  return result;
+}
+
+static inline int16_t NoiseRngWhite(NoiseRng *r) // 16 bit white noise sample - low half of each word first, then high half (same order as the TRNG)
+{
+  if (r->half)
+  {
+    r->half = 0;
+    return r->word >> 16;
+  }
+  r->word = NoiseRngNext(r);
+  r->half = 1;
+  return r->word;
+}
+
+static inline int32_t MulQ31(int32_t a, int32_t b) // multiply by a Q31 fraction - compiles to a single smull & shift on the Cortex-M3
+{
+  return (int32_t) (((int64_t) a * b) >> 31);
+}
+
+// Colour one white noise sample - no divides. Each section is y = x - b.x[-1] + a.y[-1], a low freq shelf
+// between a pole & a zero. Poles are spaced geometrically & each zero sits a fraction of the way to the next
+// pole, so the shelves add up to a staircase approximating a constant slope of 0 to -6dB per octave.
+// Cost: 2 smull's per section - estimated at about 85 cycles per sample on the Due with 6 sections (including gain & clipping)
+// The result is in 12 bit DAC steps x 4096 - see NoiseDacScale()
+static inline int32_t NoiseColourFilter(int16_t white, const NoisePoleCoefs *p, const NoiseColourCoefs *c, NoiseFilterState *s)
+{
+  int32_t v = MulQ31((int32_t) white << 8, c->gain); // +/- 2^23 for white input, leaving headroom for low freq boost
+  int32_t prev = s->in;
+  s->in = v;
+  for (uint8_t k = 0; k < NOISE_SECTIONS; k++)
+  {
+    int32_t y = v - MulQ31(c->b[k], prev) + MulQ31(p->a[k], s->y[k]);
+    prev = s->y[k];
+    s->y[k] = y;
+    v = y;
+  }
+  return v;
+}
+
+// Direct form 1 biquad with 64 bit accumulation - 5 smlal's, estimated at about 30 cycles on the Due
+static inline int32_t NoiseBiquad(int32_t x, const NoiseBiquadCoefs *c, NoiseBiquadState *s)
+{
+  int64_t acc = (int64_t) c->b0 * x + (int64_t) c->b1 * s->x1 + (int64_t) c->b2 * s->x2 - (int64_t) c->a1 * s->y1 - (int64_t) c->a2 * s->y2;
+  int32_t y = acc >> 28;
+  s->x2 = s->x1;
+  s->x1 = x;
+  s->y2 = s->y1;
+  s->y1 = y;
+  return y;
+}
+
+static inline int16_t NoiseDacScale(int32_t v) // filter output to 12 bit DAC steps centred on 0
+{
+  v >>= 12;
+  if (v > 2047) v = 2047;
+  else if (v < -2048) v = -2048;
+  return v;
+}
+
+// Output gain stage: the filter output (12 bit DAC steps x 4096) is multiplied by a 32 bit Q28 gain, so quiet
+// levels keep their 12 fractional bits, then TPDF dither (2 uniform values each 1 step wide) is added before
+// rounding to 12 bits. Dither turns the quantisation error into a steady 0.5 step RMS noise floor instead of
+// distortion that follows the signal, so levels down to about -60 dB stay noise-like. Estimated 12 cycles per sample.
+#define NOISE_UNITY_GAIN (1 << 28) // Q28 gain of 1 (0 dB)
+#define NOISE_AMP_MAX    4000000   // max amplitude (+12 dB) - above 1000000 the noise is amplified & clips, as the old colouring filter's did at full volume
+#define NOISE_MIDSCALE   2048      // DAC value for 0 V out of the DAC's range
+
+static inline int32_t NoiseGain(uint32_t amp) // amplitude in millionths (1000000 = 0 dB, as na) to a Q28 gain
+{
+  if (amp > NOISE_AMP_MAX) amp = NOISE_AMP_MAX;
+  return (uint64_t) amp * 1152921504607ULL >> 32; // 1152921504607 = 2^60 / 1000000
+}
+
+static inline uint16_t NoiseDacOutput(int32_t v, int32_t gain, uint32_t *dither) // apply gain & TPDF dither, returns a DAC value centred on NOISE_MIDSCALE
+{
+  v = (int64_t) v * gain >> 28;
+  uint32_t d = *dither * 1664525 + 1013904223; // LCG - only the top 24 bits are used
+  *dither = d;
+  v += (int32_t) (d >> 20) + (int32_t) ((d >> 8) & 0xFFF) - 2048; // TPDF dither of +/- 1 step, + 1/2 step so >> rounds to nearest
+  v = (v >> 12) + NOISE_MIDSCALE;
+  if (v > 4095) v = 4095;
+  else if (v < 0) v = 0;
+  return v;
+}
+
+// Filter design - all constexpr, so the coefficient tables are calculated by the compiler & stored in flash.
+// Only +, -, * & / are used, so the tables come out bit-identical on every compiler (& in tools/noisebank.py)
+
+constexpr int32_t CxQ31(double f)
+{
+  return f >= 1.0 ? 0x7FFFFFFF : (int32_t) (f * 2147483648.0);
+}
+
+constexpr int32_t CxQ28(double f)
+{
+  return (int32_t) (f * 268435456.0 + (f < 0 ? -0.5 : 0.5));
+}
+
+constexpr double NoisePole(uint8_t k, double rate) // pole coefficient of section k
+{
+  double freq = NOISE_POLE0;
+  while (k--) freq *= NOISE_POLE_RATIO;
+  return CxExp(-2 * 3.141592653589793 * freq / rate);
+}
+
+constexpr double NoiseZero(uint8_t k, uint16_t colour, double rate) // zero coefficient of section k
+{
+  double slope = (1000 - colour) / 1000.0; // amplitude slope: 0 = flat, 1 = -6dB per octave
+  double freq = NOISE_POLE0 * CxExp(slope * NOISE_LN_RATIO); // zero is this fraction of the way to the next pole (on a log scale)
+  while (k--) freq *= NOISE_POLE_RATIO;
+  return CxExp(-2 * 3.141592653589793 * freq / rate);
+}
+
+constexpr NoisePoleCoefs NoisePoleDesign(double rate)
+{
+  NoisePoleCoefs p {};
+  for (uint8_t k = 0; k < NOISE_SECTIONS; k++) p.a[k] = CxQ31(NoisePole(k, rate));
+  return p;
+}
+
+// colour: 1000 = white, 500 = pink (-3dB/oct), 0 = brown (-6dB/oct). The gain keeps the output level at NOISE_RMS for all colours
+constexpr NoiseColourCoefs NoiseColourDesign(uint16_t colour, double rate)
+{
+  NoiseColourCoefs c {};
+  double a[NOISE_SECTIONS] {}, b[NOISE_SECTIONS] {}, r[NOISE_SECTIONS] {};
+  for (uint8_t k = 0; k < NOISE_SECTIONS; k++)
+  {
+    a[k] = NoisePole(k, rate);
+    b[k] = NoiseZero(k, colour, rate);
+    c.b[k] = CxQ31(b[k]);
+  }
+  // white noise power gain = sum of the squared impulse response. With partial fractions H = D + sum(r[k] / (1 - a[k]/z))
+  // & D + sum(r[k]) = h[0] = 1, so the sum is 1 + sum over j & k of r[j].r[k].a[j].a[k] / (1 - a[j].a[k])
+  for (uint8_t k = 0; k < NOISE_SECTIONS; k++)
+  {
+    double num = 1, den = 1;
+    for (uint8_t j = 0; j < NOISE_SECTIONS; j++)
+    {
+      num *= 1 - b[j] / a[k];
+      if (j != k) den *= 1 - a[j] / a[k];
+    }
+    r[k] = num / den;
+  }
+  double power = 1;
+  for (uint8_t k = 0; k < NOISE_SECTIONS; k++)
+  {
+    for (uint8_t j = 0; j < NOISE_SECTIONS; j++) power += r[k] * r[j] * a[k] * a[j] / (1 - a[k] * a[j]);
+  }
+  // uniform 16 bit white noise is 18919 RMS, which is 1182 RMS after shifting to 12 bits
+  c.gain = CxQ31(NOISE_RMS / (1182.0 * CxSqrt(power)));
+  return c;
+}
+
+// Octave band noise: white noise through a 4th order Butterworth high-pass at fc / sqrt(2) & a 4th order Butterworth
+// low-pass at fc x sqrt(2) - 3dB down at the band edges & 24 dB per octave outside. 4 biquads, estimated at about 150
+// cycles per sample including the white noise source - 36% of the CPU at 200kHz, 71% at 400kHz
+#define NOISE_BANDS         4  // octave bands centred on NOISE_BAND0_FREQ, doubling each band (4, 8, 16 & 32 kHz)
+#define NOISE_BAND_SECTIONS 4  // biquads per band
+#define NOISE_BAND0_FREQ    4000.0
+
+struct NoiseBandCoefs
+{
+  NoiseBiquadCoefs s[NOISE_BAND_SECTIONS];
+};
+
+// Checks for biquads uploaded with ni. A section is stable when both its poles are inside the unit circle: |a2| < 1 &
+// |a1| < 1 + a2. The peak gain to each section's output (the sum of |impulse response| through the sections before it)
+// must be under NOISE_IIR_GAIN_MAX, so full scale white noise (16 bits x 256) can't overflow the 32 bit section state,
+// or the output gain stage at NOISE_AMP_MAX (4 x 2^23 x 60 < 2^31)
+#define NOISE_IIR_GAIN_MAX 60.0
+#define NOISE_IIR_LENGTH   16384 // impulse response samples summed - a filter still ringing after this is too close to unstable
+
+static inline bool NoiseBiquadStable(const NoiseBiquadCoefs *c)
+{
+  int64_t a1 = c->a1, a2 = c->a2;
+  return a2 < (1LL << 28) && a2 > -(1LL << 28) && (a1 < 0 ? -a1 : a1) < (1LL << 28) + a2;
+}
+
+static inline float NoiseIirPeakGain(const NoiseBandCoefs *c, uint8_t sections) // largest peak gain to any section's output - 0 if the impulse response hasn't died away by NOISE_IIR_LENGTH
+{
+  float st[NOISE_BAND_SECTIONS][4] = {}; // x1, x2, y1, y2
+  float sum[NOISE_BAND_SECTIONS] = {};
+  for (uint16_t i = 0; i < NOISE_IIR_LENGTH; i++)
+  {
+    float v = i == 0, ring = 0;
+    for (uint8_t k = 0; k < sections; k++)
+    {
+      const NoiseBiquadCoefs &q = c->s[k];
+      float y = ((float) q.b0 * v + (float) q.b1 * st[k][0] + (float) q.b2 * st[k][1] - (float) q.a1 * st[k][2] - (float) q.a2 * st[k][3]) * (1.0f / (1L << 28));
+      st[k][1] = st[k][0]; st[k][0] = v;
+      st[k][3] = st[k][2]; st[k][2] = y;
+      sum[k] += fabsf(y);
+      ring += fabsf(st[k][2]) + fabsf(st[k][3]);
+      v = y;
+    }
+    if (i > 2 && ring < 1e-7f)
+    {
+      float peak = 0;
+      for (uint8_t k = 0; k < sections; k++) if (sum[k] > peak) peak = sum[k];
+      return peak;
+    }
+  }
+  return 0;
+}
+
+struct NoiseBandTable
+{
+  NoiseBandCoefs band[NOISE_BANDS];
+};
+
+// 2nd order high-pass or low-pass biquad (RBJ audio EQ cookbook), with its output multiplied by gain
+constexpr NoiseBiquadCoefs NoisePassDesign(bool highPass, double freq, double q, double gain, double rate)
+{
+  double w = 2 * 3.141592653589793 * freq / rate;
+  double cosW = CxCos(w), alpha = CxSin(w) / (2 * q), a0 = 1 + alpha;
+  double b0 = (highPass ? (1 + cosW) / 2 : (1 - cosW) / 2) * gain / a0;
+  return { CxQ28(b0), CxQ28(highPass ? -2 * b0 : 2 * b0), CxQ28(b0), CxQ28(-2 * cosW / a0), CxQ28((1 - alpha) / a0) };
+}
+
+constexpr NoiseBandTable NoiseBandDesign(double rate)
+{
+  NoiseBandTable t {};
+  double fc = NOISE_BAND0_FREQ;
+  for (uint8_t i = 0; i < NOISE_BANDS; i++)
+  {
+    double f1 = fc / 1.4142135623730951, f2 = fc * 1.4142135623730951;
+    // gain to bring the band back up to NOISE_RMS: noise bandwidth of a 4th order Butterworth is 1.026 x its cut-off freq
+    double bandwidth = 1.026 * f2 - f1 / 1.026;
+    double gain = NOISE_RMS / (1182.0 * CxSqrt(bandwidth / (rate / 2)));
+    t.band[i].s[0] = NoisePassDesign(true, f1, 0.5412, 1, rate); // Butterworth Q's for 4th order: 0.5412 & 1.3066
+    t.band[i].s[1] = NoisePassDesign(true, f1, 1.3066, 1, rate);
+    t.band[i].s[2] = NoisePassDesign(false, f2, 0.5412, 1, rate);
+    t.band[i].s[3] = NoisePassDesign(false, f2, 1.3066, gain, rate);
+    fc *= 2;
+  }
+  return t;
+}
+
+// 0, 1, 2 ... N-1 as a template parameter pack, made by halves so the template depth stays small
+template <uint16_t... I> struct NoiseSeq {};
+template <class S1, class S2> struct NoiseSeqJoin;
+template <uint16_t... I, uint16_t... J> struct NoiseSeqJoin<NoiseSeq<I...>, NoiseSeq<J...> >
+{
+  typedef NoiseSeq<I..., (sizeof...(I) + J)...> type;
+};
+template <uint16_t N> struct MakeNoiseSeq
+{
+  typedef typename NoiseSeqJoin<typename MakeNoiseSeq<N / 2>::type, typename MakeNoiseSeq<N - N / 2>::type>::type type;
+};
+template <> struct MakeNoiseSeq<0> { typedef NoiseSeq<> type; };
+template <> struct MakeNoiseSeq<1> { typedef NoiseSeq<0> type; };
+
+struct NoiseColourTable
+{
+  NoiseColourCoefs colour[NOISE_COLOURS];
+};
+
+template <uint16_t... I>
+constexpr NoiseColourTable MakeNoiseColourTable(double rate, NoiseSeq<I...>)
+{
+  return {{ NoiseColourDesign(I, rate)... }};
+}
+
+// Speaker compensation EQ (see tools/speakereq.py & speakereq.h). A Linkwitz transform: its zeros cancel the speaker's
+// 2nd order high-pass at f0 & new poles put it back at the lower freq fp. Bilinear transform without pre-warping, as the
+// freqs are far below the sample rate. Scaled to 0 dB at low freq, so it never boosts & can't clip - high freqs are cut
+// by (fp / f0)^2 instead (12 dB with speakereq.py's default boost). Only built once speakereq.h holds a measurement
+constexpr NoiseBiquadCoefs SpeakerEqDesign(double f0, double q0, double fp, double qp, double rate)
+{
+  double k = 2 * rate;
+  double w0 = 2 * 3.141592653589793 * f0, wp = 2 * 3.141592653589793 * fp;
+  double g = (wp * wp) / (w0 * w0);
+  double d = k * k + k * wp / qp + wp * wp;
+  return { CxQ28(g * (k * k + k * w0 / q0 + w0 * w0) / d), CxQ28(g * 2 * (w0 * w0 - k * k) / d), CxQ28(g * (k * k - k * w0 / q0 + w0 * w0) / d),
+           CxQ28(2 * (wp * wp - k * k) / d), CxQ28((k * k - k * wp / qp + wp * wp) / d) };
+}
+
+#ifdef SPEAKER_F0
+static constexpr NoiseBiquadCoefs NoiseSpeakerEq = SpeakerEqDesign(SPEAKER_F0, SPEAKER_Q0, SPEAKER_FP, SPEAKER_QP, NOISE_RATE);
+#endif
+static constexpr NoiseBandTable   NoiseBands   = NoiseBandDesign(NOISE_RATE);
+static constexpr NoisePoleCoefs   NoisePoles   = NoisePoleDesign(NOISE_RATE);
+static constexpr NoiseColourTable NoiseColours = MakeNoiseColourTable(NOISE_RATE, MakeNoiseSeq<NOISE_COLOURS>::type()); // 28 kBytes
+
+// The complete noise generator - used by the Due (FillNoiseBlock() & TC2_Handler) & by tools/noise_render.cpp
+struct NoiseGenerator
+{
+  const NoisePoleCoefs   *poles;  // colour filter poles
+  const NoiseColourCoefs *colour; // colour filter gain & zeros - change with a single pointer write while running
+  const NoiseBandCoefs   *band;   // octave band filter - 0 for broadband (colour filter)
+  const NoiseBiquadCoefs *eq;     // speaker EQ - 0 for none
+  NoiseFilterState state;
+  NoiseBiquadState bandState[NOISE_BAND_SECTIONS];
+  NoiseBiquadState eqState;
+  uint32_t dither;                // dither generator state - see NoiseDacOutput()
+};
+
+static inline void NoiseReset(NoiseGenerator *g) // clear filter history & restart the dither, so frozen noise is the same every time
+{
+  g->state = NoiseFilterState();
+  for (uint8_t k = 0; k < NOISE_BAND_SECTIONS; k++) g->bandState[k] = NoiseBiquadState();
+  g->eqState = NoiseBiquadState();
+  g->dither = 0;
+}
+
+struct NoiseRngSource // white noise source for NoiseRender() from a seeded generator
+{
+  NoiseRng *rng;
+  int16_t operator()() { return NoiseRngWhite(rng); }
+};
+
+// 1 noise sample in 12 bit DAC steps x 4096. white() supplies 16 bit white noise - as a template so each
+// source gets its own inlined copy, without testing which source is in use on every sample
+template <class White>
+static inline int32_t NoiseFilter(NoiseGenerator *g, White &white)
+{
+  int32_t v;
+  if (g->band) // octave band noise
+  {
+    v = (int32_t) white() << 8;
+    for (uint8_t k = 0; k < NOISE_BAND_SECTIONS; k++) v = NoiseBiquad(v, &g->band->s[k], &g->bandState[k]);
+  }
+  else v = NoiseColourFilter(white(), g->poles, g->colour, &g->state);
+  if (g->eq) v = NoiseBiquad(v, g->eq, &g->eqState);
+  return v;
+}
+
+template <class White>
+static inline int16_t NoiseRender(NoiseGenerator *g, White &white) // 1 noise sample at full scale, in 12 bit DAC steps centred on 0 - as the noise bank
+{
+  return NoiseDacScale(NoiseFilter(g, white));
+}
+
+template <class White>
+static inline uint16_t NoiseOutput(NoiseGenerator *g, White &white, int32_t gain) // 1 noise sample for the DAC, at a Q30 gain
+{
+  return NoiseDacOutput(NoiseFilter(g, white), gain, &g->dither);
+}
+
+// FIR filter uploaded over serial (nf) - used instead of the colour filter for any other noise spectrum.
+// Block oriented: white noise for up to NOISE_FIR_CHUNK samples is made first, then each output is a plain
+// multiply-accumulate over the taps, & the newest inputs are kept as history for the next chunk. The taps are Q15,
+// applied to 12 bit white noise, so the 32 bit sum can't overflow while the sum of |taps| is under NOISE_FIR_SUM_MAX.
+#define NOISE_FIR_TAPS    128
+#define NOISE_FIR_CHUNK   128
+#define NOISE_FIR_SUM_MAX (32L << 15) // sum of |taps| must be below 32.0
+
+struct NoiseFir
+{
+  int16_t  h[NOISE_FIR_TAPS];                       // taps in Q15 - h[0] multiplies the newest input
+  uint16_t taps;                                    // number of taps in use - 0 = off
+  int16_t  x[NOISE_FIR_TAPS - 1 + NOISE_FIR_CHUNK]; // input history, followed by the new chunk of input
+};
+
+static inline int32_t NoiseFirSum(const int16_t *h, const int16_t *x, uint16_t taps) // 1 FIR output - x points at the newest input
+{
+  int32_t acc = 0;
+  uint16_t k = 0;
+  for (; k + 4 <= taps; k += 4, x -= 4) acc += h[k] * x[0] + h[k + 1] * x[-1] + h[k + 2] * x[-2] + h[k + 3] * x[-3]; // unrolled x 4
+  for (; k < taps; k++, x--) acc += h[k] * x[0];
+  return acc;
+}
+
+template <class White>
+static inline void NoiseFirRender(NoiseGenerator *g, NoiseFir *f, White &white, uint16_t *out, uint16_t len, int32_t gain) // len DAC samples through the FIR filter, speaker EQ & gain stage
+{
+  int16_t *x = f->x + NOISE_FIR_TAPS - 1; // new input goes after the history
+  while (len)
+  {
+    uint16_t n = len < NOISE_FIR_CHUNK ? len : NOISE_FIR_CHUNK;
+    for (uint16_t i = 0; i < n; i++) x[i] = white() >> 4; // 12 bit white noise - +/- 2048 DAC steps
+    for (uint16_t i = 0; i < n; i++)
+    {
+      int32_t v = NoiseFirSum(f->h, x + i, f->taps) >> 3; // Q15 x DAC steps to DAC steps x 4096
+      if (g->eq) v = NoiseBiquad(v, g->eq, &g->eqState);
+      *out++ = NoiseDacOutput(v, gain, &g->dither);
+    }
+    for (uint16_t i = 0; i < NOISE_FIR_TAPS - 1; i++) f->x[i] = f->x[i + n]; // newest inputs become the history
+    len -= n;
+  }
+}
+
+#endif // NOISEDSP_H
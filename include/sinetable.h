@@ -0,0 +1,39 @@
+// Integer sine synthesis for the wave tables - no soft-float sin() calls (the Due's Cortex-M3 has no FPU).
+// A quarter wave table in Q15 is calculated by the compiler & stored in flash (2 kBytes). SinQ15() reads it with a
+// 32 bit phase (2^32 = 1 full cycle) & linear interpolation: max error is under 2 parts in 32767, far below the
+// 12 bit DAC step. Estimated 15 cycles per call on the Due, compared with thousands for a double precision sin().
+#ifndef SINETABLE_H
+#define SINETABLE_H
+
+#include <stdint.h>
+#include "cxmath.h"
+
+#define SINE_QUARTER 1024 // points per quarter cycle
+
+struct SineQuarterTable
+{
+  int16_t v[SINE_QUARTER + 2]; // 0 to 90 degrees inclusive, + a copy of the last point so interpolation needs no test
+};
+
+constexpr SineQuarterTable MakeSineQuarter()
+{
+  SineQuarterTable t = {};
+  for (uint16_t i = 0; i <= SINE_QUARTER; i++) t.v[i] = (int16_t) (CxSin(1.5707963267948966 * i / SINE_QUARTER) * 32767 + 0.5);
+  t.v[SINE_QUARTER + 1] = t.v[SINE_QUARTER];
+  return t;
+}
+
+static constexpr SineQuarterTable SineQuarter = MakeSineQuarter();
+
+static inline int32_t SinQ15(uint32_t phase) // sine of phase (2^32 = 360 degrees) - +/- 32767
+{
+  uint32_t quadrant = phase >> 30;
+  uint32_t pos = phase & 0x3FFFFFFF;
+  if (quadrant & 1) pos = 0x40000000 - pos; // 2nd & 4th quadrants read the table backwards
+  uint32_t i = pos >> 20;
+  int32_t frac = (pos >> 4) & 0xFFFF;
+  int32_t v = SineQuarter.v[i] + (((SineQuarter.v[i + 1] - SineQuarter.v[i]) * frac) >> 16);
+  return (quadrant & 2) ? -v : v;
+}
+
+#endif // SINETABLE_H
@@ -0,0 +1,3 @@
+// Speaker compensation for the noise EQ stage - written by tools/speakereq.py from a measured speaker response
+// No measurement has been made yet, so SPEAKER_F0 etc aren't defined & the EQ stage (ne) is left out of the build.
+// Measure the speaker's response (freq,dB CSV) & run: python3 tools/speakereq.py response.csv
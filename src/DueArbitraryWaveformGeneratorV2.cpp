@@ -1,6 +1,12 @@
 #include <Arduino.h>
 #include <debounce.h>
 #include "DueArbitraryWaveformGeneratorV2.h"
+#include "noisedsp.h"
+#include "sinetable.h"
+#include "gateshapes.h"
+#ifdef NOISEBANK
+#include "noisebank.h" // pre-rendered noise token in flash - made at build time by tools/noisebank.py
+#endif
 
 
 // The Due Arbitrary Waveform Generator was created by Bruce Evans. Version 1 was written in 2017. Some code (specifically some of the "Direct port manipulation" code found mostly at the end of this file) was adapted from Kerry D. Wong, ard_newie, Mark T, MartinL, the Magician and possibly others. Many thanks! Version 2 was developed with some inspiration from mszoke01, chhckm, gagarinui and others who commented on the create.arduino website listed below.
@@ -109,6 +115,12 @@
 // Type:   d   to set Duty-cycle type required percentage duty-cycle (0 - 100) followed by d.
 // Type:   u   to set pulse width. Type required pulse width in µ seconds followed by u. PULSE WIDTH WILL REMAIN FIXED until duty-cycle (above) is set instead.
 // Type:   e   to toggle Exact Freq Mode on/off (synchronized waves only) eliminating freq steps, but has lower sample rate, & dithering on synchronized sq. wave & sharp edges (so view on oscilliscope with HF filter on)
+// Type:   E   to toggle DDS Mode on/off: the analogue wave is read by a 32 bit phase accumulator at a fixed 1 MHz (DDS_DIVISOR) & streamed to the DAC in DMA blocks. Freq steps of 0.23 mHz at every freq with no FastMode switching, but no synchronized square wave.
+//             Above 10kHz (DDS_HF_FREQ) it interpolates between wave table points at DDS_HF_DIVISOR (1 MHz - 1.5 MHz, pushing images further from the tone, only with -D DDS_OVERRATE, as it's above the DAC's rating) - compare modes with tools/tone_thd.cpp
+// Type:   B   to toggle 2 Channel Mode on/off (turns DDS Mode on): DAC1 plays the analogue wave too, DACC tag & word mode DMA interleaving DAC0 & DAC1 samples in 1 buffer, so no extra interrupts.
+//             Each DAC gets half the DDS sample rate (500 kHz, or 750 kHz above 10kHz)
+// Type:  xo   to set DAC1's freq Offset in 2 Channel Mode: x Hz above DAC0 (negative = below, decimals allowed) - 0 gives the same tone on both, or e.g. 4o the 4 Hz beat of a binaural stimulus
+// Type:   I   to measure the DAC interrupt rate & CPU headroom (in slow mode, the cycles per interrupt of the TC0_Handler variant in use too). Above 1kHz with the square wave unsynchronized, whole cycles are streamed in buffers of up to 640 samples (1 interrupt per 4 to 40 cycles instead of 2 per cycle)
 // Type:   S   to enter the frequency Sweep mode. Follow on-screen instructions.
 // Type:   T   to enter the Timer mode. Follow on-screen instructions.
 // Type:   P   once to enable switches only, or twice for Pots. 3 times enables both. (4 times returns to disabled)
@@ -249,9 +261,12 @@ int      Delay1           = 10;      // square wave sync delay set at high sampl
 float    Delay2           = 0.55;    // square wave sync delay set at low sample rate (set high 1st)
 float    Delay3           = 110;     // square wave sync delay set at low duty
 volatile int SyncDelay    = (TimerCounts - Delay1) * Delay2; // delay of square wave for synchronization with peaks of analogue wave when analogue wave phase shift is set to 0.5
+#define  SYNC_DELAY_TICKS  5        // 42 MHz TC2 clock ticks per SyncDelay unit - the time (est. 10 CPU cycles) 1 pass of the spin-wait loop DACC_Handler used to delay with, which Delay1 to 3 were set for
+#define  SYNC_PULSE_TICKS  2        // synchronized square wave pulse at 0 or 100% duty-cycle (48nS)
 volatile bool MinOrMaxWaveDuty;     // if duty-cycle is 0% or 100% only 1 half of wave is displayed
 volatile int FastMode     = -1;     // -1 = up to 1kHz (slow mode), 0 = up to 10kHz, 1 = up to 20kHz, 2 = up to 40khz, 3 = up to 100kHz
 int      OldFastMode      = -1;     // indicates when FastMode changes.
+byte     NewWaveStale;              // bit per FastMode wave (Wave0 to Wave3) not yet rebuilt by CreateNewWave() - rebuilt by Loop_DAWG() when idle, or before FastMode changes to it
 bool     OldSquareWaveSync;         // indicates previous mode when exiting noise selection
 byte     MinMaxDuty       = 1;      // min & max duty-cycle limit for waves (in samples) due to DMA - will be set to 4 when viewing synchronized square wave to prevent polarity reversal due to DMA timing. (set to 1 with unsynchronized square wave as polarity reversal irrelevant)
 bool     PotAdjFreq[]     = {1, 1}; // {unsynchronized wave, synchronized waves}: toggles freq adjustment by pot(1) or serial(0)
@@ -267,6 +282,8 @@ float    TargetWavePulseWidth;      // synchronized waves Target pulse width in
 float    AnaPulseWidth;             // Actual Analogue Pulse Width in mSeconds
 float    LastAllowedWaveDuty = 50;  // At high freq duty cycle is limited - this is the previous allowed duty
 volatile uint32_t WaveBit;          // the bit/sample of the wave curently being processed
+#define  VECTORS (16 + PERIPH_COUNT_IRQn) // Cortex-M3 exceptions + SAM3X peripheral interrupts
+__attribute__((aligned(256))) void (*RamVectors[VECTORS])(); // vector table in RAM (aligned to the next power of 2 above its size) - the TC0 vector points straight at the TC0_Handler variant for the current mode
 double   FreqIncrement = 21475000;  // the number of wave-table bits to skip in slow mode for required freq (multiplied, so we can use an int (below) instead of a float, which is faster)
 double   FreqIncrmt[3] = {21475000, 21475000}; // as above {1st half of wave, 2nd half of wave} (21475000 = half wave for 1kHz) used for calculating
 volatile uint32_t Increment[]  = {21475000, 21475000}; // as above {1st half of wave, 2nd half of wave} (21475000 = half wave for 1kHz)
@@ -283,15 +300,115 @@ double   ExactFreqModeAccuracy = 0.9999925; // ADJUST ACCURACY of Exact Freq Mod
 int      DutyMultiplier[3];                 // used when in ExactFreqMode if not at 50% duty-cycle (& not at 0 or 100%), to TRY to maintain freq
 /***********************************************************************************************/
 // For Noise: (Analogue) also see WaveShape 4 below
-int16_t  TrngNum;           // used with main low pass filter - stores TRNG random number for Noise generation
-int16_t  TrngFast;          // used with high freq filter
-int16_t  TrngSlo;           // used with low freq filter
-uint8_t  TrngCount;         // sets timing for low freq filter
-uint16_t NoiseCol   = 3500; // Noise colour with altered linearity: 3500 = Pink noise
-uint16_t NoiseLFB   = 0;    // Low freq boost - balance
-uint16_t NoiseFil   = 100;  // Main low pass filter - balance
-uint16_t NoiseHFB   = 0;    // High freq boost - balance
-uint16_t NoiseLFC   = 15;   // Low freq boost - cut-off freq
+NoiseGenerator Noise = {&NoisePoles, &NoiseColours.colour[500], 0, 0}; // noise filters in use & their history - see noisedsp.h. Colour set by NoiseFilterSetup(), speaker EQ by ne & octave band by SetNoiseBand()
+byte     NoiseBand = 0;        // 0 = broadband noise (colour filter), 1 to 4 = octave band noise centred on 4, 8, 16 or 32 kHz (no over serial, SetNoiseBand() from main.ino), NOISE_BAND_USER = uploaded IIR (ni)
+#define  NOISE_BAND_USER 255
+NoiseBandCoefs UserIir;        // biquad sections uploaded with ni - played in place of an octave band
+NoiseFir UserFir;              // FIR filter uploaded with nf - used in place of the colour filter when UserFir.taps > 0 (DMA mode only)
+#define  NOISE_FIR_BUDGET 75   // % of CPU time the FIR noise generator may use when working out the max number of taps
+uint32_t TrngWord;             // last TRNG word read - each word is split into 2 x 16 bit white noise samples
+boolean  TrngHalf;             // high when the upper 16 bits of TrngWord are still to be used
+uint32_t XorState = 2463534242UL; // xorshift32 state - supplies white noise if the TRNG has no new word ready (re-seeded from every TRNG word)
+byte     NoiseSource = 0;      // noise source: 0 = TRNG (different every time), 1 = seeded "frozen" noise (bit-identical every time noise starts), 2 = pre-rendered noise bank in flash
+uint16_t NoiseDivisor = NOISE_DIVISOR; // noise timer divisor (42 MHz / NOISE_DIVISOR - see noisedsp.h) - set by StartNoise() to suit the noise source
+uint32_t NoiseBankPos;         // next sample to play from the noise bank (NoiseSource 2)
+uint32_t NoiseSeed   = 1;      // seed for frozen noise - set with ns over serial, or SetNoiseSeed() from main.ino
+NoiseRng FrozenRng;            // frozen noise generator - re-seeded from NoiseSeed every time noise starts
+volatile uint32_t TrngEarlyReads; // number of times a TRNG word was needed before a new one was ready (TRNG makes 1 word every 84 clocks)
+#define  NOISEBLOCK   512   // number of noise samples per DMA block (3.4 mSecs at 150kHz, 1.3 mSecs at 400kHz) - BlockFillHandler() refills one block while the other is played
+uint16_t NoiseBlock[2][NOISEBLOCK]; // double buffer of noise samples fed to the DAC by DMA when NoiseDMA is on
+volatile boolean NoiseDMA       = HIGH; // high = noise generated in blocks & streamed to the DAC by DMA (1 interrupt per block). low = original per-sample TC2_Handler (1 interrupt per sample)
+#define  NOISE_ISR_DIVISOR 210 // smallest NOISE_DIVISOR (fastest rate - 200kHz) the per-sample TC2_Handler can keep up with
+volatile boolean NoiseBlockMode = LOW;  // high while noise blocks are being streamed, so DACC_Handler refills noise blocks instead of reloading Wave0..Wave3
+volatile byte     NoiseBlockHalf = 0;   // which NoiseBlock DACC_Handler queues next - only DACC_Handler changes it
+volatile byte     NoiseFillHalf = 0;    // which NoiseBlock DACC_Handler has just queued, for BlockFillHandler() to refill
+volatile boolean  NoiseFillDue = LOW;   // high from DACC_Handler queuing a noise block until BlockFillHandler() has refilled it
+volatile uint32_t NoiseFillsLate;       // number of times DACC_Handler queued a noise block before BlockFillHandler() had refilled the last one - the CPU can't keep up with NOISE_DIVISOR
+volatile uint32_t IsrCycles;    // CPU clock cycles spent inside the noise / DMA interrupt handlers (measured with the DWT cycle counter)
+volatile uint32_t IsrCount;     // number of times the noise / DMA interrupt handlers have been entered
+volatile uint32_t DacQueued;    // samples handed to the DMA since noise, tone bank or DDS blocks started - see DacSampleNow()
+float    OnsetPhase = 0;               // phase of the sine (degrees) at which tones start & stop: 0 = rising zero crossing (mid-scale)
+volatile uint32_t OnsetSample;  // DacQueued count of the last tone's first sample - read with ToneOnset()
+volatile boolean  OnsetReady = LOW; // high once a tone's onset has been scheduled, until ToneOnset() reads it
+/***********************************************************************************************/
+// For the Tone Bank: the 4, 8, 16 & 32 kHz selector tones, rendered at boot into their own DMA buffers (see SelectTone())
+#define  TONES        4     // 4, 8, 16 & 32 kHz
+#define  TONEBLOCK  100     // samples per tone buffer (250 uSecs at 400kHz) - holds 1, 2, 4 & 8 whole cycles, so each buffer repeats seamlessly
+#define  TONE_DIVISOR 105   // tone bank timer divisor (42 MHz / 105) - clocks DAC at exactly 400kHz, so the tones are exactly 4, 8, 16 & 32 kHz
+int16_t  ToneWave[TONES][TONEBLOCK];        // full scale tones (Q15 sine) - calculated once at boot, then scaled into ToneBank by SetToneAmp()
+uint16_t ToneBank[2][TONES + 1][TONEBLOCK]; // 2 sets of DAC buffers: the set playing & the set SetToneAmp() scales into. [0] = silence (mid-scale), [1] to [TONES] = 4, 8, 16 & 32 kHz. Every buffer starts & ends at mid-scale
+volatile byte     ToneSet = 0;           // tone buffer set DACC_Handler queues from
+volatile byte     ToneSelect = 0;        // tone buffer DACC_Handler queues next: 0 = silence
+volatile byte     ToneOldSet = 0;        // number of buffers from the previous set still queued in the DMA after a level change
+volatile boolean  ToneBankMode = LOW;    // high while the tone bank is playing, so DACC_Handler re-queues tone buffers instead of reloading Wave0..Wave3
+uint32_t ToneAmp = 0;                    // amplitude of the tones in ToneBank[ToneSet]: 1000000 = 100%
+boolean  ToneAmpPending = LOW;           // high when SetToneAmp() found the other set still in the DMA - Loop_DAWG() applies ToneAmpNext once it has left
+uint32_t ToneAmpNext;                    // amplitude waiting for the other set while ToneAmpPending
+uint16_t ToneGated[2][TONEBLOCK];        // tone buffers with an onset or offset in them, or the gate applied - queued instead of ToneBank
+byte     ToneGatedHalf = 0;              // which ToneGated buffer DACC_Handler fills next
+byte     ToneQueued = 0;                 // tone in the buffer DACC_Handler queued last - differs from ToneSelect until the change is scheduled
+byte     ToneOnsetOffset[TONES];         // sample in a tone buffer at OnsetPhase - tones start & stop there (see SetOnsetPhase())
+/***********************************************************************************************/
+// For the DDS engine: the analogue wave read from WaveFull & WaveFull2 by a 32 bit phase accumulator at a fixed DAC rate & streamed in DMA blocks (E over serial)
+#ifndef DDS_DIVISOR
+#define  DDS_DIVISOR   42   // DDS timer divisor (42 MHz / 42 = 1 MHz, the DAC's max rate) - set with -D DDS_DIVISOR= in platformio.ini
+#endif
+#ifndef DDS_HF_DIVISOR
+#define  DDS_HF_DIVISOR 42  // DDS timer divisor for high freq tones (42 MHz / 42 = 1 MHz) - 28 (1.5 MHz) is above the DAC's 1 MHz rating, as FastMode 3 is (up to 1.6 MHz), so it needs -D DDS_OVERRATE as well
+#endif
+#define  DDS_HF_FREQ 10000  // DDS runs at DDS_HF_DIVISOR with interpolation above this freq (Hz)
+static_assert(DDS_DIVISOR >= 42, "the DAC can't convert faster than 1 MHz");
+#ifdef DDS_OVERRATE
+static_assert(DDS_HF_DIVISOR >= 26, "the DAC needs 25 DAC clocks per conversion");
+#else
+static_assert(DDS_HF_DIVISOR >= 42, "the DAC can't convert faster than 1 MHz - -D DDS_OVERRATE runs it above its rating");
+#endif
+uint16_t DdsDivisor = DDS_DIVISOR;      // DDS timer divisor in use (42 MHz / DdsDivisor) - set by SetDdsWave() to suit the freq
+#define  DDSBLOCK     256   // number of DDS samples per DMA block (256 uSecs at 1 MHz) - BlockFillHandler() refills one block while the other is played
+uint16_t DdsBlock[2][2 * DDSBLOCK];     // double buffer of DDS samples fed to the DAC by DMA - 2 channel mode interleaves DAC0 & DAC1 samples, so a block is twice as long
+volatile byte     DdsBlockHalf = 0;     // which DdsBlock DACC_Handler queues next - only DACC_Handler changes it
+volatile byte     DdsFillHalf = 0;      // which DdsBlock DACC_Handler has just queued, for BlockFillHandler() to refill
+volatile boolean  DdsFillDue = LOW;     // high from DACC_Handler queuing a DDS block until BlockFillHandler() has refilled it
+volatile uint32_t DdsFillsLate;         // number of times DACC_Handler queued a DDS block before BlockFillHandler() had refilled the last one - shown by I
+volatile boolean  DdsBlockMode = LOW;   // high while DDS blocks are being streamed, so DACC_Handler refills DDS blocks instead of reloading Wave0..Wave3
+boolean  DdsMode = LOW;                 // high = analogue wave (not noise) played by the DDS engine instead of FastMode / slow mode
+struct DdsChannel                       // DDS phase accumulator for 1 DAC
+{
+  uint32_t Phase;                       // position in the current wave half: 2^32 = 1 wave half (4096 points)
+  byte     Half;                        // current wave half: 0 = 1st (WaveFull), 1 = 2nd (WaveFull2)
+  volatile uint32_t Increment[2];       // phase added per sample in each wave half - set from the target freq & duty-cycle by SetDdsWave()
+  volatile uint32_t Ratio[2];           // Increment[half] / Increment[other half] (x 65536) - scales the phase carried into each wave half
+};
+DdsChannel Dds[2];                      // [0] = DAC0, [1] = DAC1 (2 channel mode only)
+volatile boolean  DdsStereo = LOW;      // high = 2 channel mode: DAC1 plays the same wave as DAC0, DdsOffset Hz higher (B over serial)
+double   DdsOffset = 0;                 // DAC1 freq - DAC0 freq (Hz) in 2 channel mode - the beat freq of binaural stimuli (o over serial)
+volatile boolean  DdsOneHalf;           // high at 0 or 100% duty-cycle: only 1 wave half is played
+volatile boolean  DdsInterpolate;       // high = interpolate between wave table points (high freq tones at DDS_HF_DIVISOR)
+uint32_t DdsOnsetPhase = 0x80000000;    // DdsChannel Phase & Half the DDS engine starts at - OnsetPhase in WaveFull & WaveFull2 (they start at the sine's +ve peak)
+byte     DdsOnsetHalf  = 1;
+#define  MULTIBLOCK   640   // max samples per whole cycle DMA buffer - 4, 8, 16 or 40 cycles at FastMode 0 to 3
+int16_t  MultiWave[2][MULTIBLOCK];      // whole cycles of the FastMode wave laid back to back - 2 sets, so one can be rewritten while the other plays
+volatile uint16_t MultiLength[2];       // samples in each MultiWave set (whole cycles only)
+uint16_t          MultiCycles[2];       // whole cycles in each MultiWave set
+volatile byte     MultiSet = 0;         // MultiWave set DACC_Handler queues
+volatile byte     MultiOldSet = 0;      // DMA buffers left to finish before the other set is free to rewrite
+boolean           MultiPending = LOW;   // high when UpdateMultiCycleWave() found the other set still in the DMA - Loop_DAWG() tries again once it has left
+volatile boolean  MultiCycleMode = LOW; // high = DACC_Handler queues MultiWave (1 interrupt per MULTIBLOCK samples) instead of half cycles - only when the square wave isn't synchronized
+/***********************************************************************************************/
+// For the Gate: rise & fall envelopes applied to each sample as noise, tone bank & DDS blocks are filled (no over serial, SetGate() & StartGate() from main.ino). Shapes in gateshapes.h
+#define  GATE_OFF       0   // GateState: no envelope - blocks are played untouched
+#define  GATE_CLOSED    1   // silent (mid-scale)
+#define  GATE_RISE      2
+#define  GATE_OPEN      3   // full level for GateHold samples
+#define  GATE_FALL      4
+#define  GATE_HOLD_ON 0xFFFFFFFF // GateHold: stay open until GateRelease()
+const uint16_t *GateRiseShape = GateShapes.shape[GATE_COS2].v; // rise table, Q15 (32768 = full level) - set by SetGate()
+const uint16_t *GateFallShape = GateShapes.shape[GATE_COS2].v; // fall table - read backwards
+volatile byte     GateState = GATE_OFF;
+volatile uint32_t GatePos;              // position in the ramp: 2^32 = whole ramp
+volatile uint32_t GateInc;              // GatePos added per sample - 2^32 / ramp samples
+volatile uint32_t GateHold;             // samples left at full level before the fall starts
+float    GateRamp = 0;                  // rise & fall time (mSecs) - 0 = gate off
 /********************************************************/
 uint32_t WaveAmp     = 65536;  // WaveAmp multiplier used in exact-freq mode for 'live' software volume control
 // For Setup parameters:
@@ -303,6 +420,15 @@ float    SinPhase    = 0.5;  // Phase shift
 float    SinFreq2    = 8;    // Sinewave 2 (2nd sinewave) Frequency Multiple. (X times Sinewave 1)
 float    SinAddMix   = 0;    // Sinewave 2 percentage Mix in Add Waves mode
 float    SinMulMix   = 0;    // Sinewave 2 percentage Mix in Multiply Waves mode
+struct SineMix              // Sine wave settings in fixed point for CreateWaveFull() - see SineMixSetup()
+{
+  byte    mode;              // 0 = single sine wave, 1 = 2nd sine wave added, 2 = multiplied, 3 = both
+  int32_t add1, add2;        // addition mix (Q15)
+  int32_t mul1, mul2;        // multiplication mix (Q15)
+  int32_t bias1, bias2;      // multiplication bias (Q15)
+  int32_t amp;               // amplitude in DAC steps (Q12)
+};
+uint32_t WaveBuildCycles;    // CPU clock cycles taken by the last CreateWaveFull() (shown by s0)
 // WaveShape 1 - Triangle Wave:
 float    TriAmp      = 1.0;  // Amplitude / slope
 float    TriVshift   = 0.5;  // Vertical shift
@@ -319,7 +445,7 @@ float    ComSinAmp   = 0.5;  // Sine Wave mix
 float    ComTriAmp   = 0.5;  // Triangle Wave mix
 float    ComArbAmp   = 0.5;  // Arbitrary Wave mix
 // WaveShape 4 - TRNG Noise:
-uint16_t NoiseAmp    = 0;  // Amplitude
+uint32_t NoiseAmp    = 0;  // Amplitude: 1000000 = 100% (0 dB), up to NOISE_AMP_MAX - applied as a 32 bit gain with dither, see NoiseDacOutput() in noisedsp.h
 uint16_t NoiseColour = 500; // Noise colour: 500 = Pink noise
 /********************************************************/
 // For Modulation & Music:
@@ -454,6 +580,9 @@ void Setup_DAWG()
   //pinMode(51, OUTPUT); // indicates: switches enabled
   pmc_enable_periph_clk(ID_TRNG);
   trng_enable(TRNG);
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // enable DWT cycle counter - used to measure interrupt CPU load (see PrintCpuLoad)
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  RamVectorSetup(); // before TC0's interrupt is enabled
   dac_setup();  // set up fast mode for dac
   TimerCounts = freqToTc(TargetWaveFreq); // for TC_setup()
   dac_setup2(); // set up slow mode for dac
@@ -465,7 +594,7 @@ void Setup_DAWG()
   if (TargetFreq < 163 || SquareWaveSync) PIO_Configure(PIOC, PIO_PERIPH_B, PIO_PC28B_TIOA7, PIO_DEFAULT); // enable pin 3
   else pinMode(7, OUTPUT); // Square wave PWM output
   randomSeed(analogRead(3)); // for arbitrary random wave only (not noise) - A0 & A1 used for pots. A2 used for modulation
-  
+  ToneBankSetup(); // tone bank at full scale - played when main.ino calls StartToneBank()
   Setup2();
 }
 
@@ -497,12 +626,45 @@ void Settings(byte defaultMode, int preset, boolean sendToGUI) // defaultMode: 0
   if (defaultMode > 0) Setup2(); // otherwise if defaultMode == 0 (at start-up) return to normal setup()
 }
 
+static void SineMixSetup(SineMix *m) // sine wave mix settings (s0+ & s0*) in fixed point, for SineMixPoint()
+{
+  float sin1AddAmp = (100 - SinAddMix) / 100; // addition mix
+  float sin1MulAmp = min(1, (100 - SinMulMix) / 50); // multiplication mix
+  float sin2MulAmp = min(1, SinMulMix / 50);
+  float sin2AddAmp = 1 - sin1AddAmp;
+  if      (sin2AddAmp == 0 && sin2MulAmp == 0) m->mode = 0; // single sine wave
+  else if (sin2AddAmp > 0  && sin2MulAmp > 0)  m->mode = 3; // both added & multiplied
+  else if (sin2AddAmp > 0)                     m->mode = 1; // added
+  else                                         m->mode = 2; // multiplied
+  m->add1  = sin1AddAmp * 32768 + 0.5;
+  m->add2  = 32768 - m->add1;
+  m->mul1  = sin1MulAmp * 32768 + 0.5;
+  m->mul2  = sin2MulAmp * 32768 + 0.5;
+  m->bias1 = 32768 - m->mul1;
+  m->bias2 = 32768 - m->mul2;
+  m->amp   = (m->mode == 3 ? SinAmp / 2 : SinAmp) * ((WAVERESOL - 1) / 2) * 4096 + 0.5; // Q12
+}
+
+static inline int32_t SineMixPoint(const SineMix *m, int32_t sin1, int32_t sin2) // 1 point of the sine wave (before vertical shift) from 2 Q15 sines
+{
+  int32_t mix; // Q15
+  if (m->mode == 0) mix = (sin1 * m->mul1) >> 15;
+  else
+  {
+    mix = 0;
+    if (m->mode & 1) mix = (sin1 * m->add1 + sin2 * m->add2) >> 15;
+    if (m->mode & 2) mix += ((((sin1 * m->mul1) >> 15) + m->bias1) * (((sin2 * m->mul2) >> 15) + m->bias2)) >> 15;
+  }
+  return ((int64_t) mix * m->amp + (1 << 26)) >> 27; // rounded
+}
+
 void CreateWaveFull(byte setupSelection) // WaveFull: for low freq use; prevents 'sample' noise at very low audio freq's (sample-skipping used without DMA)
 {
    //       Serial.print("cws InterruptMode = "); Serial.println(InterruptMode);
+  uint32_t startCycles = DWT->CYCCNT;
   bool loweredSampleRate = 0; // 1 = sample rate lowered during wave calculation to speed it up, as DueStorage library uses too much of the little remaining CPU time!
   volatile uint32_t increment[] = {Increment[0], Increment[1]}; // remember setting - used to return sample size to normal after reduced sample rate
-  if (FastMode < 0 && WaveShape != 4)
+  if (FastMode < 0 && WaveShape != 4 && !(WaveShape == 0 && setupSelection == 0) && !ToneBankMode && !DdsBlockMode) // sine wave only is quick to calculate (integer sine synthesis), so no need to lower the sample rate. Not while TC0 channel 0 clocks DMA blocks
   {
     loweredSampleRate = 1; // 1 = sample rate lowered during wave calculation, as DueStorage library uses too much of the little remaining CPU time!
     if (InterruptMode > 0 || TargetFreq < 163 || (WaveShape == 3 && OldFastMode < 0 && ComArbAmp != 0 && ArbMirror == 0)) // if low freq with interrupt instead of PWM, OR while calculating WaveShape 3 with ComArbAmp != 0 in slow mode with mirror effect OFF (as constraining needed in interrupt handler which uses more CPU time)
@@ -670,34 +832,36 @@ void CreateWaveFull(byte setupSelection) // WaveFull: for low freq use; prevents
         waveTemp1 = vShift1 + TriAmp * (stepVolts - HALFRESOL);
       }
     }
-    if (WaveShape == 3 && OldFastMode < 0 && ComArbAmp != 0 && ArbMirror == 0 && InterruptMode == 0) InterruptMode = 10; // constrained in the interrupt handler, but only during calculating of WaveShape 3 in slow mode if mirror effect is OFF as constraining here causes clipping and incorrect mixing of high amplitude waves. This makes the wave look good during calculating, although it slows the calculating process a little.
+    SineMix sineMix;        // - Sine wave: mix settings in fixed point, worked out once rather than for every point
+    uint32_t sinPhase1 = 0; // - Sine wave: phase of wave 1 at index 0 (2^32 = 1 cycle = NWAVEFULL * 2 points)
+    uint32_t sinStep1  = 0x80000000UL / NWAVEFULL; // - Sine wave: phase steps per point for wave 1 & for the 2nd sine wave
+    uint32_t sinStep2  = 0;
+    if (setupSelection == 0 || setupSelection == 10)
+    {
+      SineMixSetup(&sineMix);
+      sinPhase1 = (uint32_t) (int64_t) round(SinPhase * 2147483648.0); // SinPhase * NWAVEFULL points
+      sinStep2  = (uint32_t) round(SinFreq2) * sinStep1;
+    }
+    if (WaveShape == 3 && OldFastMode < 0 && ComArbAmp != 0 && ArbMirror == 0 && InterruptMode == 0) { InterruptMode = 10; SelectTc0Handler(); } // constrained in the interrupt handler, but only during calculating of WaveShape 3 in slow mode if mirror effect is OFF as constraining here causes clipping and incorrect mixing of high amplitude waves. This makes the wave look good during calculating, although it slows the calculating process a little.
     for (int index = 0; index < NWAVEFULL; index++) // create the individual samples for the wave - (1st half cycle: 12 bit range, 4096 steps.  2nd half cycle: 12 bit range, 4096 steps)
     {
       if (WaveShape == 0 || setupSelection == 0 || setupSelection == 10) // Sine wave - 1st wave half saved into full wave table - 2nd wave half saved into 2nd full wave table, inverted around it's centre only if single (main) sine wave displayed. Or calculate 2nd wave half (without inverting) for 2 waves
       {
-        float sin1AddAmp = (100 - SinAddMix) / 100; // addition mix = UserInput;
-        float sin1MulAmp = min(1, (100 - SinMulMix) / 50); // multiplication mix
-        float sin2MulAmp = min(1, SinMulMix / 50);
-        float sin2AddAmp = 1 - sin1AddAmp;
-        float sin1MulBias = 1 - sin1MulAmp;
-        float sin2MulBias = 1 - sin2MulAmp;
         if (setupSelection == 0 || setupSelection == 10) // setupSelection = 10 at starup to pre-calculate wave 0 & wave 1
         {
-          if      (sin2AddAmp == 0 && sin2MulAmp == 0) waveTemp = (int32_t)  ((SinAmp       *   (sin((PI / NWAVEFULL) * (index + (SinPhase * NWAVEFULL))) * sin1MulAmp) * halfResol) + vShift0); // save temporarily into a 32 bit signed int to allow large minus calculations.
-          else if (sin2AddAmp > 0  && sin2MulAmp > 0)  waveTemp = (int32_t) ((((SinAmp / 2) *  ((sin((PI / NWAVEFULL) * (index + (SinPhase * NWAVEFULL))) * sin1AddAmp)                  +  (sin(((SinFreq2 * PI) / NWAVEFULL) * index) * sin2AddAmp) + (((sin((PI / NWAVEFULL) * (index + (SinPhase * NWAVEFULL))) * sin1MulAmp) + sin1MulBias) * ((sin(((SinFreq2 * PI) / NWAVEFULL) * index) * sin2MulAmp) + sin2MulBias)))) * halfResol) + vShift0);
-          else if (sin2AddAmp > 0)                     waveTemp = (int32_t) (((SinAmp       *  ((sin((PI / NWAVEFULL) * (index + (SinPhase * NWAVEFULL))) * sin1AddAmp)                  +  (sin(((SinFreq2 * PI) / NWAVEFULL) * index) * sin2AddAmp)))                  * halfResol) + vShift0);
-          else if (sin2MulAmp > 0)                     waveTemp = (int32_t) (((SinAmp       * (((sin((PI / NWAVEFULL) * (index + (SinPhase * NWAVEFULL))) * sin1MulAmp) + sin1MulBias)   * ((sin(((SinFreq2 * PI) / NWAVEFULL) * index) * sin2MulAmp) + sin2MulBias))) * halfResol) + vShift0);
+          waveTemp = SineMixPoint(&sineMix, SinQ15(sinPhase1 + index * sinStep1), SinQ15(index * sinStep2)) + vShift0; // integer sine synthesis - see sinetable.h
           WaveSin[index] = constrain(waveTemp, -HALFRESOL, halfResol); // save 1st wave half into 1st half sine table. WaveSin[] stores data to enable quick copying into WaveFull[] when changing wave shape
         }
         //    Serial.print(index); Serial.print(" W = "); Serial.println(waveTemp);
         if (WaveShape == 0) WaveFull[index] = constrain(WaveSin[index] + HALFRESOL, 0, WAVERESOL-1); // save 1st wave half into full wave table, constrained between min & max values.
         if (setupSelection == 0 || setupSelection == 10) // setupSelection = 10 at starup to pre-calculate wave 0 & wave 1. 2nd wave half saved into 2nd full wave table, inverted around it's centre:
         {
-          if      (sin2AddAmp == 0 && sin2MulAmp == 0) WaveSin2[index] = constrain(vShift0 - waveTemp + vShift0, -HALFRESOL, halfResol); // if single (main) 1st wave with no addition or multiplication save 2nd half cycle into 2nd half cycle sine table, inverted around it's centre
-          else if (sin2AddAmp > 0  && sin2MulAmp > 0)  waveTemp = (int32_t) ((((SinAmp / 2) * ((sin((PI / NWAVEFULL) * (index + NWAVEFULL + (SinPhase * NWAVEFULL))) * sin1AddAmp)                  +  (sin(((SinFreq2 * PI) / NWAVEFULL) * (index + NWAVEFULL )) * sin2AddAmp) + (((sin((PI / NWAVEFULL) * (index + NWAVEFULL + (SinPhase * NWAVEFULL))) * sin1MulAmp) + sin1MulBias) * ((sin(((SinFreq2 * PI) / NWAVEFULL) * (index + NWAVEFULL )) * sin2MulAmp) + sin2MulBias)))) * halfResol) + vShift0); // if both 2nd sine wave addition and multiplication amplitude are greater than zero, calculate 2nd wave half (without inverting or reversing) for both waves
-          else if (sin2AddAmp > 0)                     waveTemp = (int32_t) (((SinAmp       * ((sin((PI / NWAVEFULL) * (index + NWAVEFULL + (SinPhase * NWAVEFULL))) * sin1AddAmp)                  +  (sin(((SinFreq2 * PI) / NWAVEFULL) * (index + NWAVEFULL )) * sin2AddAmp))) * halfResol) + vShift0); // if 2nd sine wave addition amplitude greater than zero, calculate 2nd wave half (without inverting or reversing) for both waves
-          else if (sin2MulAmp > 0)                     waveTemp = (int32_t) (((SinAmp      * (((sin((PI / NWAVEFULL) * (index + NWAVEFULL + (SinPhase * NWAVEFULL))) * sin1MulAmp) + sin1MulBias)   * ((sin(((SinFreq2 * PI) / NWAVEFULL) * (index + NWAVEFULL )) * sin2MulAmp) + sin2MulBias))) * halfResol) + vShift0); // if 2nd sine wave multiplication amplitude greater than zero, calculate 2nd wave half (without inverting or reversing) for both waves
-          if      (sin2AddAmp > 0 || sin2MulAmp > 0)   WaveSin2[index] = constrain(waveTemp, -HALFRESOL, halfResol); // save 2nd wave half into full wave table, constrained between min & max values
+          if (sineMix.mode == 0) WaveSin2[index] = constrain(vShift0 - waveTemp + vShift0, -HALFRESOL, halfResol); // if single (main) 1st wave with no addition or multiplication save 2nd half cycle into 2nd half cycle sine table, inverted around it's centre
+          else // if 2nd sine wave added or multiplied, calculate 2nd wave half (without inverting or reversing) for both waves
+          {
+            waveTemp = SineMixPoint(&sineMix, SinQ15(sinPhase1 + (index + NWAVEFULL) * sinStep1), SinQ15((index + NWAVEFULL) * sinStep2)) + vShift0;
+            WaveSin2[index] = constrain(waveTemp, -HALFRESOL, halfResol); // save 2nd wave half into full wave table, constrained between min & max values
+          }
         }
         //    Serial.print(index); Serial.print("\t  W2 = "); Serial.println(WaveSin2[index]);
         if (WaveShape == 0) WaveFull2[index] = constrain(WaveSin2[index] + HALFRESOL, 0, WAVERESOL-1); // Copy into final wavetable
@@ -780,7 +944,7 @@ void CreateWaveFull(byte setupSelection) // WaveFull: for low freq use; prevents
       // Serial.print(index); Serial.print(" WF = "); Serial.println(waveTemp);
     }
      //     Serial.print("cwb4e InterruptMode = "); Serial.println(InterruptMode);
-    if (WaveShape == 3 && ArbMirror == 0 && InterruptMode == 10) InterruptMode = 0;
+    if (WaveShape == 3 && ArbMirror == 0 && InterruptMode == 10) { InterruptMode = 0; SelectTc0Handler(); }
   }
   if (loweredSampleRate) // return sample rate to usual rate, as wave calculation is finished
   {
@@ -790,10 +954,56 @@ void CreateWaveFull(byte setupSelection) // WaveFull: for low freq use; prevents
     else TC_setup2(); // return analogue slow mode timing to normal sample rate (from reduced rate during calculating, to speed it up)
   }
       //    Serial.print("cwe InterruptMode = "); Serial.println(InterruptMode);
+  WaveFull[NWAVEFULL]  = WaveFull2[0]; // end points continue into the other wave half - read by the DDS engine's interpolation
+  WaveFull2[NWAVEFULL] = WaveFull[0];
+  WaveBuildCycles = DWT->CYCCNT - startCycles;
   CreateWaveTable();
   CreateNewWave();
 }
 
+void SineBenchmark() // s0b: time the sine wave calculation with the original soft-float sin() maths & with integer sine synthesis, & compare them
+{
+  float sin1AddAmp = (100 - SinAddMix) / 100; // the original maths, as CreateWaveFull() had it
+  float sin1MulAmp = min(1, (100 - SinMulMix) / 50);
+  float sin2MulAmp = min(1, SinMulMix / 50);
+  float sin2AddAmp = 1 - sin1AddAmp;
+  float sin1MulBias = 1 - sin1MulAmp;
+  float sin2MulBias = 1 - sin2MulAmp;
+  uint16_t halfResol = (WAVERESOL - 1) / 2;
+  SineMix sineMix;
+  SineMixSetup(&sineMix);
+  uint32_t sinPhase1 = (uint32_t) (int64_t) round(SinPhase * 2147483648.0);
+  uint32_t sinStep1  = 0x80000000UL / NWAVEFULL;
+  uint32_t sinStep2  = (uint32_t) round(SinFreq2) * sinStep1;
+  volatile int32_t sink;
+  int32_t maxError = 0;
+  uint32_t cycles[2];
+  for (byte pass = 0; pass < 3; pass++) // pass 0: float, pass 1: integer, pass 2: compare
+  {
+    uint32_t startCycles = DWT->CYCCNT;
+    for (int index = 0; index < NWAVEFULL * 2; index++) // both wave halves
+    {
+      int32_t f = 0, n = 0;
+      if (pass != 1)
+      {
+        if      (sineMix.mode == 0) f = (int32_t)  (SinAmp       *   (sin((PI / NWAVEFULL) * (index + (SinPhase * NWAVEFULL))) * sin1MulAmp) * halfResol);
+        else if (sineMix.mode == 3) f = (int32_t) (((SinAmp / 2) *  ((sin((PI / NWAVEFULL) * (index + (SinPhase * NWAVEFULL))) * sin1AddAmp)                  +  (sin(((SinFreq2 * PI) / NWAVEFULL) * index) * sin2AddAmp) + (((sin((PI / NWAVEFULL) * (index + (SinPhase * NWAVEFULL))) * sin1MulAmp) + sin1MulBias) * ((sin(((SinFreq2 * PI) / NWAVEFULL) * index) * sin2MulAmp) + sin2MulBias)))) * halfResol);
+        else if (sineMix.mode == 1) f = (int32_t) ((SinAmp       *  ((sin((PI / NWAVEFULL) * (index + (SinPhase * NWAVEFULL))) * sin1AddAmp)                  +  (sin(((SinFreq2 * PI) / NWAVEFULL) * index) * sin2AddAmp)))                  * halfResol);
+        else                        f = (int32_t) ((SinAmp       * (((sin((PI / NWAVEFULL) * (index + (SinPhase * NWAVEFULL))) * sin1MulAmp) + sin1MulBias)   * ((sin(((SinFreq2 * PI) / NWAVEFULL) * index) * sin2MulAmp) + sin2MulBias))) * halfResol);
+      }
+      if (pass != 0) n = SineMixPoint(&sineMix, SinQ15(sinPhase1 + index * sinStep1), SinQ15(index * sinStep2));
+      if (pass < 2) sink = f + n;
+      else maxError = max(maxError, abs(f - n));
+    }
+    if (pass < 2) cycles[pass] = DWT->CYCCNT - startCycles;
+  }
+  Serial.print("   Sine wave calculation, "); Serial.print(NWAVEFULL * 2); Serial.println(" points (measured):");
+  Serial.print("   soft-float sin(): "); Serial.print(cycles[0]); Serial.print(" cycles ("); Serial.print(cycles[0] / 84000.0, 1); Serial.println(" mSecs)");
+  Serial.print("   integer sine:     "); Serial.print(cycles[1]); Serial.print(" cycles ("); Serial.print(cycles[1] / 84000.0, 1); Serial.println(" mSecs)");
+  Serial.print("   max difference:   "); Serial.print(maxError); Serial.println(" DAC steps");
+  Serial.print("   last full rebuild (CreateWaveFull): "); Serial.print(WaveBuildCycles); Serial.print(" cycles ("); Serial.print(WaveBuildCycles / 84000.0, 1); Serial.println(" mSecs)\n");
+}
+
 void CreateWaveTable() // WaveTable: a smaller wave for higher freq use; faster to copy from smaller table into NewWave (below) [It takes 50% longer to copy from full wave above!]
 {
   float reduce = NWAVEFULL / 160.0;
@@ -803,64 +1013,131 @@ void CreateWaveTable() // WaveTable: a smaller wave for higher freq use; faster
     WaveTable2[index] = (uint16_t) WaveFull2[round(index * reduce)]; // 2nd wave half
     // Serial.print(index); Serial.print(" WT = "); Serial.println(WaveTable[index]);
   }
+  WaveTable[NWAVETABLE]  = WaveTable[NWAVETABLE - 1]; // resampling (below) can land 1 point past the end - repeat the last point there
+  WaveTable2[NWAVETABLE] = WaveTable2[NWAVETABLE - 1];
 }
 
 // NewWave: For analogue wave frequencies above 1kHz. Samples from WaveTable to be copied here with selected duty cycle, for copying by DMA
-void CreateNewWave() // create the individual samples for each FastMode wave whenever the duty-cycle is changed (copy from WaveTable)
+void CreateNewWave() // create the individual samples for each FastMode wave whenever the duty-cycle is changed (copy from WaveTable). Only the wave now playing is rebuilt here - the other 3 are rebuilt later by CreateStaleNewWave()
 {
-  boolean wh = !WaveHalf; // idendifies which half of wave is CURRENTLY being written by DMA - (LOW = 1st half of wave [positive going half])
   byte fm = max(0, FastMode); // capture the current FastMode
-  for (int cycle = 0; cycle < 4; cycle++) // update all 4 FastMode waves, current one first
+  NewWaveStale = 0x0F;
+  CreateFastModeWave(fm);
+}
+
+void CreateStaleNewWave(byte fm) // rebuild a FastMode wave if CreateNewWave() left it for later
+{
+  if (NewWaveStale & (1 << fm)) CreateFastModeWave(fm);
+}
+
+void CreateFastModeWave(byte fm)
+{
+  if (WaveHalf == LOW) // LOW = 2nd half of wave is CURRENTLY being written by DMA
   {
-    byte dv = 0;
-    if (TargetWaveDuty == 0 || TargetWaveDuty == 100) dv++; // if displaying one half of wave only divide by 1 less (next lines) to maintain full amplitude as both 0 & 4095 will be included in same half
-    float inc0 = float(NWAVETABLE - dv) / (Duty[0][fm] - dv); // calculate increment needed for sampling 1st half wave from wavetable the required number of steps (depending on duty-cycle)
-    float inc1 = float(NWAVETABLE) / (Duty[1][fm] - dv); // calculate increment needed for sampling 2nd half wave from wavetable the required number of steps (depending on duty-cycle)
-    if (wh == HIGH)
-    {
-      if (TargetWaveDuty >   0) Create1stHalfNewWave(fm, inc0); // update next half wave cycle first (causes less disturbance to wave especially at high freq's)
-      if (TargetWaveDuty < 100) Create2ndHalfNewWave(fm, inc1); // update current half wave cycle afterwards
-    }
-    else // if (wh ==  LOW)
-    {
-      if (TargetWaveDuty < 100) Create2ndHalfNewWave(fm, inc1); // update next half wave cycle first (causes less disturbance to wave especially at high freq's)
-      if (TargetWaveDuty >   0) Create1stHalfNewWave(fm, inc0); // update current half wave cycle afterwards
-    }
-    if (fm < 3) fm++;
-    else fm = 0;
+    if (TargetWaveDuty >   0) Create1stHalfNewWave(fm); // update next half wave cycle first (causes less disturbance to wave especially at high freq's)
+    if (TargetWaveDuty < 100) Create2ndHalfNewWave(fm); // update current half wave cycle afterwards
   }
+  else
+  {
+    if (TargetWaveDuty < 100) Create2ndHalfNewWave(fm); // update next half wave cycle first (causes less disturbance to wave especially at high freq's)
+    if (TargetWaveDuty >   0) Create1stHalfNewWave(fm); // update current half wave cycle afterwards
+  }
+  NewWaveStale &= ~(1 << fm);
+  if (fm == FastMode) UpdateMultiCycleWave();
 }
-void Create1stHalfNewWave(byte fm, float inc0)
+
+void UpdateMultiCycleWave() // lay whole cycles of the current FastMode wave back to back in the other MultiWave set, then swap sets - unless the square wave is synchronized, which needs an interrupt per wave half
 {
-  //  Serial.println("Half 1");
-  float  x = 0;
-  for (int index = 0; index < Duty[0][fm]; index++) // 1st half of cycle
-  { // separate files used (Wave0 - 3) instead of arrays to reduce memory useage: [since Wave3 is much smaller than Wave0]
-    if ((TargetWaveDuty > 0 && TargetWaveDuty < 100) || index != 0) x = min(NWAVETABLE - 1, x + inc0);
-    if      (fm == 0) Wave0[0][index] = WaveTable[round(x)];
-    else if (fm == 1) Wave1[0][index] = WaveTable[round(x)];
-    else if (fm == 2) Wave2[0][index] = WaveTable[round(x)];
-    else if (fm == 3) Wave3[0][index] = WaveTable[round(x)];
-    //    if      (fm == 3) {Serial.print(index); Serial.print("ArbUpload = "); Serial.print(round(x)); Serial.print(" val = "); Serial.println(Wave3[0][index]);}
+  if (FastMode < 0 || SquareWaveSync)
+  {
+    MultiCycleMode = LOW;
+    MultiPending = LOW;
+    return;
+  }
+  MultiPending = MultiOldSet && !NoiseBlockMode && !DdsBlockMode && !ToneBankMode; // only if changed again within 2 buffers (8 mSecs max) - rather than wait here (forever if the DMA has stopped)
+  if (MultiPending) return;
+  byte set = !MultiSet;
+  const int16_t *wave[2];
+  if      (FastMode == 0) { wave[0] = Wave0[0]; wave[1] = Wave0[1]; }
+  else if (FastMode == 1) { wave[0] = Wave1[0]; wave[1] = Wave1[1]; }
+  else if (FastMode == 2) { wave[0] = Wave2[0]; wave[1] = Wave2[1]; }
+  else                    { wave[0] = Wave3[0]; wave[1] = Wave3[1]; }
+  uint16_t len[2] = {(uint16_t) Duty[0][FastMode], (uint16_t) Duty[1][FastMode]};
+  if (MinOrMaxWaveDuty) // if duty set to 0 or 100 - only the wave half played (as DACC_Handler: Wave[!WaveHalf])
+  {
+    wave[0] = wave[!WaveHalf];
+    len[0]  = len[!WaveHalf];
+    len[1]  = 0;
+  }
+  uint16_t cycle = len[0] + len[1];
+  uint16_t n = 0;
+  while (n + cycle <= MULTIBLOCK)
+  {
+    memcpy(&MultiWave[set][n], wave[0], len[0] * 2);
+    memcpy(&MultiWave[set][n + len[0]], wave[1], len[1] * 2);
+    n += cycle;
   }
+  MultiLength[set] = n;
+  MultiCycles[set] = n / cycle;
+  MultiSet = set;   // DACC_Handler queues the new wave from the next buffer on - always at a whole cycle
+  MultiOldSet = 2;  // the DMA buffer playing & the one queued may be from the old set
+  MultiCycleMode = HIGH;
 }
-void Create2ndHalfNewWave(int fm, float inc1)
+
+// Resample a wave half from WaveTable (span points) into count samples: wave[i] = table[round(k * span / (count - oneHalf))], k = i + !oneHalf.
+// Bresenham style - an integer add & a carry per sample instead of a float add, min() & round() (estimated 8 cycles per sample, from over 200)
+template <uint16_t SAMPLES> static void ResampleHalf(int16_t (&wave)[SAMPLES], const int16_t *table, uint16_t count, uint16_t span, bool oneHalf)
 {
-  //  Serial.println("Half 2");
-  float  x = 0;
-  for (int index = 0; index < Duty[1][fm]; index++) // 2nd half of cycle
-  { // separate files used (Wave0 - 3) instead of arrays to reduce memory useage: [since Wave3 is much smaller than Wave0]
-    if ((TargetWaveDuty > 0 && TargetWaveDuty < 100) || index != 0) x = min(NWAVETABLE - 1, x + inc1); // if displaying one half of wave only start from full amplitude
-    if      (fm == 0) Wave0[1][index] = WaveTable2[round(x)];
-    else if (fm == 1) Wave1[1][index] = WaveTable2[round(x)];
-    else if (fm == 2) Wave2[1][index] = WaveTable2[round(x)];
-    else if (fm == 3) Wave3[1][index] = WaveTable2[round(x)];
-    //    if      (fm == 3) {Serial.print(index); Serial.print("b = "); Serial.print(round(x)); Serial.print(" val = "); Serial.println(Wave3[1][index]);}
+  count = min(count, SAMPLES);
+  uint32_t steps = count - oneHalf; // table steps across the wave half
+  if (steps == 0)
+  {
+    if (count) wave[0] = table[0];
+    return;
+  }
+  uint32_t den   = 2 * steps;                         // position = (2 * k * span + steps) / den - rounded to nearest
+  uint32_t pos   = 2 * (!oneHalf) * span + steps;
+  uint32_t index = pos / den, rem = pos % den;        // if displaying one half of wave only start from full amplitude (k = 0)
+  uint32_t step  = (2 * span) / den, stepRem = (2 * span) % den;
+  for (uint16_t i = 0; i < count; i++)
+  {
+    wave[i] = table[index]; // index reaches NWAVETABLE at the last sample - WaveTable[NWAVETABLE] repeats the last point
+    rem   += stepRem;
+    uint32_t carry = rem >= den;
+    index += step + carry;
+    rem   -= den & -carry;
   }
 }
 
+void Create1stHalfNewWave(byte fm)
+{
+  bool oneHalf = (TargetWaveDuty == 0 || TargetWaveDuty == 100); // if displaying one half of wave only divide by 1 less to maintain full amplitude as both 0 & 4095 will be included in same half
+  uint16_t span = NWAVETABLE - oneHalf;
+  // separate files used (Wave0 - 3) instead of arrays to reduce memory useage: [since Wave3 is much smaller than Wave0]
+  if      (fm == 0) ResampleHalf(Wave0[0], WaveTable, Duty[0][0], span, oneHalf);
+  else if (fm == 1) ResampleHalf(Wave1[0], WaveTable, Duty[0][1], span, oneHalf);
+  else if (fm == 2) ResampleHalf(Wave2[0], WaveTable, Duty[0][2], span, oneHalf);
+  else if (fm == 3) ResampleHalf(Wave3[0], WaveTable, Duty[0][3], span, oneHalf);
+}
+void Create2ndHalfNewWave(byte fm)
+{
+  bool oneHalf = (TargetWaveDuty == 0 || TargetWaveDuty == 100);
+  if      (fm == 0) ResampleHalf(Wave0[1], WaveTable2, Duty[1][0], NWAVETABLE, oneHalf);
+  else if (fm == 1) ResampleHalf(Wave1[1], WaveTable2, Duty[1][1], NWAVETABLE, oneHalf);
+  else if (fm == 2) ResampleHalf(Wave2[1], WaveTable2, Duty[1][2], NWAVETABLE, oneHalf);
+  else if (fm == 3) ResampleHalf(Wave3[1], WaveTable2, Duty[1][3], NWAVETABLE, oneHalf);
+}
+
 void Loop_DAWG()
 {
+  if (MultiPending && !MultiOldSet) UpdateMultiCycleWave(); // the other MultiWave set has left the DMA now
+  if (ToneAmpPending && !(ToneBankMode && ToneOldSet)) SetToneAmp(ToneAmpNext); // & the other tone buffer set
+  if (NewWaveStale) // rebuild 1 FastMode wave left for later by CreateNewWave() per pass
+  {
+    byte fm = 0;
+    while (!(NewWaveStale & (1 << fm))) fm++;
+    CreateFastModeWave(fm);
+  }
   if (millis() > SwitchPressedTime + 500) // check state of pot enable switch:
   {
     bool keyPressed = 0;
@@ -1456,13 +1733,7 @@ void Loop_DAWG()
         UserInput = ArbitraryWave[ArbitraryPointNumber];
         if (WaveShape == 4) // if exiting noise selection
         {
-          NVIC_DisableIRQ(TC2_IRQn); // disable noise IRQ
-          if (FastMode >= 0)
-          {
-            TC_setup();
-            dac_setup();
-          }
-          else TC_setup2();
+          StopNoise();
           if (OldSquareWaveSync) ToggleSquareWaveSync(1); // restore Sychronized Square Wave if necessary
         }
         WaveShape = 2;
@@ -1582,6 +1853,9 @@ void Loop_DAWG()
                     Serial.println("");
                   }
                   break;
+                case 'b': // if received s0b
+                  SineBenchmark();
+                  break;
                   case 'w': // if received s0w
                   WaveAmp = UserInput;
                   if (!UsingGUI) {
@@ -1643,6 +1917,7 @@ void Loop_DAWG()
                     Serial.println(  "   s0+ - to Add waves      - mix: 0 to 100     (50 = both) (default = 0s0+)");
                     Serial.println(  "   s0* - to Multiply waves - mix: 0 to 100     (50 = both) (default = 0s0*)");
                     Serial.println(  "   Hint: 50s0* = ring modulation. 76s0* = amplitude mod. 100s0* = 2nd wave");
+                    Serial.println(  "   s0b - Benchmark: time the sine wave calculation (soft-float sin() vs integer)");
                     Serial.println(  "   Current values: ");
                     Serial.print(    "   Amplitude = "); Serial.print(SinAmp * 1000000, 0); Serial.print(    "   WaveAmp = "); Serial.print(WaveAmp); Serial.print(", Bias = "); Serial.print(SinVshift * 100, 0); Serial.print(", Phase = "); Serial.println(SinPhase);
                     Serial.print(    "   Freq multiple = "); Serial.print(SinFreq2, 0); Serial.print(", Add waves Mix = "); Serial.print(SinAddMix, 0); Serial.print(", Multiply waves Mix = "); Serial.println(SinMulMix, 0); Serial.println("\n");
@@ -1829,7 +2104,7 @@ void Loop_DAWG()
           }
           if (UserChars[1] == 'a')       // if received na
           {
-            NoiseAmp = constrain(UserInput, 0, 1000000);
+            NoiseAmp = constrain(UserInput, 0, NOISE_AMP_MAX);
             Serial.print("   Noise Amplitude is "); Serial.println(UserInput); Serial.println("");
           }
           else if (UserChars[1] == 'c')
@@ -1844,23 +2119,118 @@ void Loop_DAWG()
             else if (UserChars[1] == 'b') NoiseColour = 30;   // brown -  if received nb
             NoiseFilterSetup();
           }
+          else if (UserChars[1] == 'd' && NoiseDMA && NOISE_DIVISOR < NOISE_ISR_DIVISOR) Serial.println("   Per-sample noise interrupts can't keep up with this NOISE_DIVISOR - staying with DMA\n");
+          else if (UserChars[1] == 'd') // if received nd - toggle noise generation between DMA blocks & per-sample interrupt
+          {
+            if (WaveShape == 4) StopNoise();
+            NoiseDMA = !NoiseDMA;
+            if (WaveShape == 4) StartNoise();
+            Serial.print("   Noise DMA is "); Serial.println(NoiseDMA ? "ON\n" : "OFF\n");
+          }
+          else if (UserChars[1] == 'e') // if received ne - toggle speaker compensation EQ
+          {
+            #ifdef SPEAKER_F0
+            noInterrupts(); // between DMA blocks
+            Noise.eqState = NoiseBiquadState(); // start from silence, not from the state left when it was last on
+            Noise.eq = Noise.eq ? 0 : &NoiseSpeakerEq;
+            interrupts();
+            Serial.print("   Speaker EQ is "); Serial.println(Noise.eq ? "ON\n" : "OFF\n");
+            #else
+            Serial.println("   No speaker EQ in this build - it needs a measured speaker response, see tools/speakereq.py\n");
+            #endif
+          }
+          else if (UserChars[1] == 'o') // if received no - octave band noise
+          {
+            SetNoiseBand(UserInput);
+            if (NoiseBand) {Serial.print("   Octave band noise centred on "); Serial.print(2 << NoiseBand); Serial.println(" kHz\n");}
+            else Serial.println("   Broadband noise\n");
+          }
+          else if (UserChars[1] == 'l') PrintCpuLoad(); // if received nl - measure interrupt CPU load
+          else if (UserChars[1] == 'f') // if received nf - FIR noise filter, followed by the taps
+          {
+            if (UserInput > NOISE_FIR_TAPS) {Serial.print("   Up to "); Serial.print(NOISE_FIR_TAPS); Serial.println(" FIR taps\n");}
+            else if (UserInput >= 1) LoadNoiseFir(UserInput);
+            else
+            {
+              UserFir.taps = 0;
+              Serial.println("   FIR filter off - colour filter");
+              PrintFirBudget();
+            }
+          }
+          else if (UserChars[1] == 'i') // if received ni - IIR noise filter, followed by the biquad coefficients
+          {
+            if (UserInput > NOISE_BAND_SECTIONS) {Serial.print("   Up to "); Serial.print(NOISE_BAND_SECTIONS); Serial.println(" biquad sections\n");}
+            else if (UserInput >= 1) LoadNoiseIir(UserInput);
+            else
+            {
+              SetNoiseBand(0);
+              Serial.println("   IIR filter off - broadband noise\n");
+            }
+          }
+          else if (UserChars[1] == 's' || UserChars[1] == 't') // if received ns - frozen noise with seed, or nt - TRNG noise
+          {
+            if (UserChars[1] == 's' && (UserInput < 0 || UserInput > 4294967295.0 || UserInput != floor(UserInput))) Serial.println("   The seed must be a whole number from 0 to 4294967295\n"); // UserInput is built digit by digit in a double, which holds every whole number up to 2^53 exactly, so any 32 bit seed arrives unchanged
+            else
+            {
+              if (UserChars[1] == 's') SetNoiseSeed((uint32_t) UserInput);
+              else NoiseSource = 0;
+              if (WaveShape == 4) StartNoise(); // restart so frozen noise begins from the start of its sequence
+              PrintNoiseSource();
+              Serial.println("");
+            }
+          }
+          else if (UserChars[1] == 'k') // if received nk - play pre-rendered noise bank from flash
+          {
+            #ifdef NOISEBANK
+            NoiseSource = 2;
+            if (WaveShape == 4) StartNoise(); // restart from the start of the noise bank
+            #else
+            Serial.println("   No noise bank in this build - it's made by tools/noisebank.py when built with PlatformIO");
+            #endif
+            PrintNoiseSource();
+            Serial.println("");
+          }
           else if (!UsingGUI) // if received n with no more valid char's after it - Noise Help (WaveShape 4):
           {
             Serial.println("\n   True Random Noise Generator Commands:       (\"Wave Shape\" 4)");
             Serial.println(  "   Type a number followed by:");
-            Serial.println(  "   na - noise Amplitude - range: 0 to 1000000     (default = 100)");
+            Serial.println(  "   na - noise Amplitude - range: 0 to 4000000 (1000000 = 0 dB, default = 100)");
             Serial.println(  "   nc - noise Colour    - range: 0 to 1000 (default = 500 - pink)\n");
             Serial.println(  "   Preset Noise Colours:      (only when noise is displayed)");
             Serial.println(  "   nw - sets noise colour to White (1000)");
             Serial.println(  "   np - sets noise colour to Pink  (500)");
             Serial.println(  "   nb - sets noise colour to Brown (30)");
+            Serial.println(  "   ns - seed: frozen noise - the same noise every time it starts (number is the seed)");
+            Serial.println(  "   nt - TRNG noise - different every time (default)");
+            Serial.println(  "   nk - noise bank - pre-rendered noise played from flash (colour set at build time)");
+            Serial.println(  "   no - octave band noise centred on 4, 8, 16 or 32 kHz (number is the freq in kHz - 0 for broadband)");
+            Serial.println(  "   ne - toggles speaker compensation EQ (boosts low freqs by up to 12 dB, relative to high freqs - needs a measured speaker response)");
+            Serial.println(  "   nd - toggles noise generation between DMA blocks & per-sample interrupt");
+            Serial.println(  "   nl - measures CPU Load of noise / DMA interrupts");
+            Serial.println(  "   nf - FIR filter: number of taps (up to 128), nf, then the taps (Q15) separated by spaces - 0nf = off");
+            Serial.println(  "        (DMA mode only - tools/noisefir.py designs them. Prints the max taps for each sample rate)");
+            Serial.println(  "   ni - IIR filter: number of biquads (up to 4), ni, then b0 b1 b2 a1 a2 (Q28) for each - 0ni = off");
             Serial.println(  "   Current Settings: ");
-            Serial.print(    "   Amplitude is "); Serial.print(int(NoiseAmp)); Serial.print(  " & Colour is "); Serial.println(int(NoiseColour)); Serial.println("\n");
+            Serial.print(    "   Amplitude is "); Serial.print(int(NoiseAmp)); Serial.print(  " & Colour is "); Serial.println(int(NoiseColour));
+            PrintNoiseSource();
+            Serial.println("\n");
           }
           break;
         case 'w': // Change Wave Shape
           ChangeWaveShape(1);
           break;
+        case 'E': // toggle DDS Mode
+          ToggleDdsMode();
+          break;
+        case 'B': // toggle 2 channel (DAC0 & DAC1) DDS output
+          ToggleDdsStereo();
+          break;
+        case 'o': // DAC1 freq offset in 2 channel mode
+          SetDdsOffset(UserInput);
+          break;
+        case 'I': // measure DMA interrupt rate & CPU headroom
+          PrintCpuLoad();
+          break;
         case 'e': // toggle ExactFreqMode
           if (WaveShape != 4) ToggleExactFreqMode(); // toggle ExactFreqMode if Noise not selected
           else Serial.print("   Cannot set Exact Freq Mode while Noise is enabled");
@@ -1901,8 +2271,10 @@ void Loop_DAWG()
             {
               Serial.print("   Freq Sweep: Min freq = "); Serial.print(SweepMinFreq); Serial.print(" Hz. Max freq = "); Serial.print(SweepMaxFreq); Serial.print(" Hz. Rise time = "); Serial.print(SweepRiseTime); Serial.print(" Sec. Fall time = "); Serial.print(SweepFallTime); Serial.println(" Sec");
             }
-            if  (ExactFreqMode) Serial.print("   Exact Freq Mode is ON ");
-            else                Serial.print("   Exact Freq Mode is OFF");
+            if (DdsMode && DdsStereo) { Serial.print("   2 Channel Mode is ON: DAC1 at "); Serial.print(DdsOffset, 3); Serial.println(" Hz above DAC0"); }
+            if      (DdsMode)       Serial.print("   DDS Mode is ON        ");
+            else if (ExactFreqMode) Serial.print("   Exact Freq Mode is ON ");
+            else                    Serial.print("   Exact Freq Mode is OFF");
             if (SquareWaveSync) Serial.println("  Square Wave is Synchronized with Analogue Wave");
             else                Serial.println("  Square Wave is Unsynchronized");
             if (Control > 0 && TimerMode == 0) Serial.print(">> Analogue Wave Freq: ");
@@ -2187,6 +2559,10 @@ void Loop_DAWG()
                   Serial.println(  "   Type:   d   to set Duty-cycle, type required percentage duty-cycle (0 - 100) followed by d.");
                   Serial.println(  "   Type:   u   to set pulse width, type required pulse width in microseconds followed by u.");
                   Serial.println(  "   Type:   e   to toggle on/off Exact freq mode for analogue wave, eliminating freq steps.");
+                  Serial.println(  "   Type:   E   to toggle on/off DDS mode for analogue wave: fixed 1 MHz sample rate (interpolated above 10kHz).");
+                  Serial.println(  "   Type:   B   to toggle on/off 2 channel DDS output: DAC1 plays the analogue wave too, at half the sample rate per DAC.");
+                  Serial.println(  "   Type:  xo   to set DAC1's freq offset in 2 channel mode, where x is Hz above DAC0 (negative = below).");
+                  Serial.println(  "   Type:   I   to measure the DAC interrupt rate & CPU headroom.");
                   Serial.println(  "   Type:   S   to enter the frequency Sweep mode - follow on-screen instructions.");
                   Serial.println(  "   Type:   T   to enter the Timer mode - follow on-screen instructions.");
                   Serial.println(  "   Type:   P   once to enable switches only, or twice for Pots. 3 times enables both.");
@@ -2579,6 +2955,8 @@ void EnterTimerMode()
     if (SquareWaveSync || (WaveShape == 4 && OldSquareWaveSync)) TimerMode = 2; // if SquareWaveSync was HIGH before entering timer mode
     else TimerMode = 1; // if SquareWaveSync was LOW before entering timer mode
     SquareWaveSync = LOW; // stop Synchronized Square wave
+    SelectTc0Handler();
+    UpdateMultiCycleWave();
     TimerRun = 0;
     REG_PIOC_PER |= PIO_PER_P28; // PIO takes control of pin 3 from peripheral - similar to pinMode(3, OUTPUT)
     REG_PIOC_ODR |= PIO_ODR_P28; // PIO disables pin 3 (C28) - similar to pinMode(3, INPUT)
@@ -2666,18 +3044,13 @@ void ExitTimerMode()
 
 void ChangeWaveShape(bool sentFromSerial)
 {
+  if (ToneBankMode) StopToneBank(); // hand the DAC back to the analogue wave
   if (WaveShape == 4) // if exiting noise selection
   {
-    NVIC_DisableIRQ(TC2_IRQn); // disable noise IRQ
-    if (FastMode >= 0)
-    {
-      TC_setup();
-      dac_setup();
-    }
-    else TC_setup2();
+    StopNoise();
     if (OldSquareWaveSync)
     {
-      if (UsingGUI) Serial.print("SyncOn");
+      if (UsingGUI && !DdsMode) Serial.print("SyncOn");
       ToggleSquareWaveSync(1); // restore Sychronized Square Wave if necessary
     }
   }
@@ -2719,198 +3092,762 @@ void ChangeWaveShape(bool sentFromSerial)
     if (TimerMode == 2) OldSquareWaveSync = 1;
     else OldSquareWaveSync = SquareWaveSync;
     if (SquareWaveSync) ToggleSquareWaveSync(0); // change to Unsychronized Square Wave if sychronized
-    NVIC_DisableIRQ(TC0_IRQn); // disable TC_setup2() SlowMode IRQ before setting TC_setup1()
-    TC_setup1();
-    dac_setup2();
+    StartNoise();
 //    NoiseFilterSetup();
   }
   else if (OldSquareWaveSync) OldSquareWaveSync = 0; // if exiting noise selection & changing back to Sychronized Square Wave
 }
 
-void ToggleExactFreqMode()
+void StartNoise() // start noise generation from a known state - frozen noise (NoiseSource 1) is then identical every time
 {
-  SyncDelay = 0; // remove square wave sync delay for stability in case of sudden change to high freq
-  ExactFreqMode = !ExactFreqMode;
-  if (ExactFreqMode) Serial.println("   Exact Freq Mode is ON ");
-  else Serial.println("   Exact Freq Mode is OFF");
-  if (ExactFreqMode && TargetWaveDuty != 50) ExactFreqDutyNot50 = 1;
-  else ExactFreqDutyNot50 = 0;
-  SetWaveFreq(1);
-  SyncDelay = (TimerCounts - Delay1) * Delay2 * max((Delay3 / (abs(ActualWaveDuty - 50.0) + Delay3)), int(MinOrMaxWaveDuty)); // re-apply square wave sync delay
+  NVIC_DisableIRQ(TC0_IRQn); // disable TC_setup2() SlowMode IRQ before setting TC_setup1()
+  NoiseRngSeed(&FrozenRng, NoiseSeed);
+  NoiseBankPos = 0;
+  #ifdef NOISEBANK
+  if (NoiseSource == 2) NoiseDivisor = NOISEBANK_DIVISOR; // play noise bank at the rate it was rendered
+  else
+  #endif
+  NoiseDivisor = NOISE_DIVISOR;
+  NoiseReset(&Noise); // clear filter history
+  for (uint16_t i = 0; i < NOISE_FIR_TAPS - 1; i++) UserFir.x[i] = 0;
+  TrngHalf = LOW;
+  if (NoiseDMA) dac_setup3(); // noise streamed in blocks by DMA
+  else dac_setup2();          // noise written sample by sample by TC2_Handler
+  TC_setup1();                // start noise timer after the DAC is ready, so no samples are lost
 }
 
-void ToggleSquareWaveSync(bool exitingNoise) // exitingNoise: 1 = exiting noise selection. 0 = normal operation.
+void PrintNoiseSource()
 {
-  if (((!SquareWaveSync && WaveShape != 4) || (exitingNoise && OldSquareWaveSync)) && TimerMode == 0) // toggle SquareWaveSync to ON if Noise not selected & Timer is off
-  {
-    NVIC_DisableIRQ(TC1_IRQn);
-    PWMC_DisableChannel(PWM_INTERFACE, g_APinDescription[7].ulPWMChannel);
-    pinMode(7, INPUT);
-    PIO_Configure(PIOC, PIO_PERIPH_B, PIO_PC28B_TIOA7, PIO_DEFAULT); // enable pin 3
-    SquareWaveSync = HIGH; // start Synchronized Square wave
-    MinMaxDuty = 4; // allow min (& max) duty-cycle of 4 samples
-    CalculateWaveDuty(0);
-    CreateNewWave();
-    WavePolarity();
-    if (WaveShape != 4) Serial.println("   Square Wave is Synchronized with Analogue Wave\n");
-  }
-  else if (SquareWaveSync && TimerMode == 0) // toggle SquareWaveSync to OFF if Timer is off (if timer is ON do nothing)
+  if (NoiseSource == 1) {Serial.print("   Frozen noise - seed "); Serial.println(NoiseSeed);}
+  #ifdef NOISEBANK
+  else if (NoiseSource == 2)
   {
-    SquareWaveSync = LOW; // stop Synchronized Square wave
-    if (TargetFreq < 163)
-    {
-      pinMode(7, INPUT); // re-enable pin after stopping
-      TC_setup3();
-    }
-    else
-    {
-      REG_PIOC_PER |= PIO_PER_P28; // PIO takes control of pin 3 from peripheral - similar to pinMode(3, OUTPUT) but faster
-      REG_PIOC_ODR |= PIO_ODR_P28; // PIO disables pin 3 (C28) - similar to pinMode(3, INPUT)
-      SetPWM(7, Period, Pulse); // PWMC_EnableChannel(PWM_INTERFACE, g_APinDescription[7].ulPWMChannel);
-    }
-    MinMaxDuty = 1; // allow min (& max) duty-cycle of 1 sample
-    CalculateWaveDuty(ExactFreqMode);
-    CreateNewWave();
-    if (WaveShape != 4) Serial.println("   Square Wave is Unsynchronized\n");
+    Serial.print("   Noise bank - "); Serial.print(NOISEBANK_SAMPLES); Serial.print(" samples at ");
+    Serial.print(42000000 / NOISEBANK_DIVISOR); Serial.println(" Hz, repeating");
   }
-  if (ExactFreqMode) SetWaveFreq(0); // ensures exact freq maintained
+  #endif
+  else Serial.println("   TRNG noise");
 }
 
-void EnterSweepMode()
+void SetNoiseBand(uint16_t kHz) // octave band noise centred on 4, 8, 16 or 32 kHz - any other freq selects broadband noise
 {
-  if (SweepMode == 0 && TimerMode == 0)
+  byte band = 0;
+  for (byte i = 0; i < NOISE_BANDS; i++) if (kHz == (4 << i)) band = i + 1;
+  if (band != NoiseBand)
   {
-    if (!UsingGUI)
-    {
-      Serial.println("\n         ************ SWEEP FREQUENCY MODE ************");
-      Serial.println("\n            (Type ? for Sweep Menu   Type q to quit)\n");
-      Serial.print("   Current Settings are:\n\tHighest freq = "); Serial.print(SweepMaxFreq); Serial.print(" Hz  \tRise time = "); Serial.print(SweepRiseTime); Serial.print(" Sec\n  \tLowest freq  = "); Serial.print(SweepMinFreq); Serial.print(" Hz  \tFall time = "); Serial.print(SweepFallTime); Serial.println(" Sec");
-      //             Serial.println(String("   Current Settings are:\n\tHighest freq = ") + SweepMaxFreq + String(" Hz  \tRise time = ") + SweepRiseTime + String(" Sec\n  \tLowest freq  = ") + SweepMinFreq + String(" Hz  \tFall time = ") + SweepFallTime + String(" Sec"));
-      if (SweepMinFreq == 0 || SweepMinFreq >= SweepMaxFreq || SweepRiseTime + SweepFallTime == 0)
-      {
-        Serial.println("   These setting are incorrect and must be changed.");
-        if (SweepMinFreq == 0 ) Serial.println("   The Lowest freq is set to zero!");
-        if (SweepMinFreq >= SweepMaxFreq) Serial.println("   The Highest freq is not higher than the Lowest freq!");
-        if (SweepRiseTime + SweepFallTime == 0) Serial.println("   Both Rise and Fall times are set to zero!");
-        Serial.println("\n   To make changes enter the desired value followed by:\n\tH for Highest freq in Hz\tR for Rise time in seconds\n\tL for Lowest freq  in Hz\tF for Fall time in seconds\n   For example: 20L 20000H 20R 20F\n");
-      }
-      else Serial.println("\n   To make changes enter the desired value followed by:\n\tH for Highest freq in Hz\tR for Rise time in seconds\n\tL for Lowest freq  in Hz\tF for Fall time in seconds\n   For example: 20L 20000H 20R 20F\n\n               Type r to start the sweep Running\n\n          ***** Type r again to stop the sweep! *****\n");
-    }
-    else Serial.println("SweepOn");
-    SweepMode = 1;
+    for (uint8_t k = 0; k < NOISE_BAND_SECTIONS; k++) Noise.bandState[k] = NoiseBiquadState(); // new band starts from silence
+    Noise.band = band ? &NoiseBands.band[band - 1] : 0;
+    NoiseBand = band;
   }
 }
 
-void ExitSweepMode()
+void LoadNoiseFir(uint16_t taps) // read FIR taps (Q15) from serial - separated by spaces or commas
 {
-  if (SweepMode > 0)
+  int16_t h[NOISE_FIR_TAPS];
+  int32_t sum = 0;
+  for (uint16_t k = 0; k < taps; k++)
   {
-    SweepMode = 0;
-    if (UsingGUI) Serial.println("SweepOff");
-    else Serial.println("           *****  Exited Sweep Frequency Mode  *****\n");
+    h[k] = constrain(Serial.parseInt(), -32768, 32767);
+    sum += abs(h[k]);
   }
+  if (sum >= NOISE_FIR_SUM_MAX) {Serial.println("   FIR taps too large - the sum of |taps| must be below 32.0 (1048576)\n"); return;}
+  noInterrupts(); // swap in the new taps between DMA blocks
+  for (uint16_t k = 0; k < taps; k++) UserFir.h[k] = h[k];
+  UserFir.taps = taps;
+  interrupts();
+  Serial.print("   FIR noise filter with "); Serial.print(taps); Serial.println(" taps");
+  if (!NoiseDMA) Serial.println("   FIR filter only runs in DMA noise mode - type nd");
+  PrintFirBudget();
 }
 
-void SweepFreq()
+void LoadNoiseIir(byte sections) // read biquad sections (b0 b1 b2 a1 a2 in Q28, y = b0.x0 + b1.x1 + b2.x2 - a1.y1 - a2.y2) from serial - only played if stable & with headroom
 {
-  float oldFreq  = TargetFreq;
-  float oldWaveFreq = TargetWaveFreq;
-  int   SweepUpdatePeriod = 25; // change freq every SweepUpdatePeriod milliseconds
-  float RiseIncrement = pow(float(SweepMaxFreq) / SweepMinFreq, 1 / (float(SweepRiseTime) / (SweepUpdatePeriod * 0.001))); // proportional freq increase required each SweepUpdatePeriod
-  float FallIncrement = pow(float(SweepMinFreq) / SweepMaxFreq, 1 / (float(SweepFallTime) / (SweepUpdatePeriod * 0.001))); // proportional freq decrease required each SweepUpdatePeriod
-  float TargetSweepFreq = SweepMinFreq;
-  float SweepIncrement = RiseIncrement;
-  unsigned long SweepUpdateTime = millis() + SweepUpdatePeriod;
-  while (1)
+  NoiseBandCoefs iir;
+  for (byte k = 0; k < NOISE_BAND_SECTIONS; k++)
   {
-    if (TargetSweepFreq >= SweepMaxFreq) SweepIncrement = FallIncrement;
-    else if (TargetSweepFreq <= SweepMinFreq) SweepIncrement = RiseIncrement;
-    if (millis() >= SweepUpdateTime)
-    {
-      SweepUpdateTime = millis() + SweepUpdatePeriod; // set next SweepUpdateTime
-      if (SweepFallTime == 0 && TargetSweepFreq >= SweepMaxFreq) TargetSweepFreq = SweepMinFreq;
-      else if (SweepRiseTime == 0 && TargetSweepFreq <= SweepMinFreq) TargetSweepFreq = SweepMaxFreq;
-      else TargetSweepFreq *= SweepIncrement;
-      if (Control > 0)
-      {
-        TargetWaveFreq = min(TargetSweepFreq, 100000);
-        SetWaveFreq(0);
-        if (Control > 1 && !UsingGUI) Serial.println();
-        if (!UsingGUI) Serial.print("\n   ");
-        if (UsingGUI) Serial.print("AAF ");
-        PrintSyncedWaveFreq();
-      }
-      if (Control != 1)
-      {
-        TargetFreq = TargetSweepFreq;
-        SetFreqAndDuty(1, 1);
-        if (UsingGUI) Serial.print("SAF ");
-        else Serial.print("\n   ");
-        PrintUnsyncedSqWaveFreq();
-      }
-    }
-    if (Serial.available() > 0 || !digitalRead(21)) // if signalled to stop Running, by serial or switch
+    if (k < sections)
     {
-      if (digitalRead(21)) UserChars[0] = Serial.read(); // if by serial
-      if (UserChars[0] == 'r' || !digitalRead(21)) // if signalled to stop Running, by serial or switch
-      {
-        SweepMode = 1;
-        if (Control > 0) // return to freq before sweep
-        {
-          TargetWaveFreq = oldWaveFreq;
-          FreqIncrement = min(TargetWaveFreq, 100000) * 21475;
-          SetWaveFreq(0);
-          if (UsingGUI) Serial.print("AAF ");
-          else Serial.print("\n   ");
-          PrintSyncedWaveFreq();
-        }
-        if (Control != 1) // return to freq before sweep
-        {
-          TargetFreq = oldFreq;
-          SetFreqAndDuty(1, 1);
-          if (UsingGUI) Serial.print("SAF ");
-          else Serial.print("\n   ");
-          PrintUnsyncedSqWaveFreq();
-        }
-        if (!UsingGUI)
-        {
-          Serial.println("\n   Sweep stopped\n");
-          Serial.print("   To repeat this freq sweep later, the following string can be entered:\n\n   "); // indent next line
-          Serial.print(SweepMinFreq); Serial.print("L"); Serial.print(SweepMaxFreq); Serial.print("H"); Serial.print(SweepRiseTime); Serial.print("R"); Serial.print(SweepFallTime); Serial.println("F  (followed by 'r' to start the sweep running)");
-          //        Serial.println(SweepMinFreq + String("L") + SweepMaxFreq + String("H") + SweepRiseTime + String("R") + SweepFallTime + String("Fr"));
-          Serial.println("\n               Type q to quit the Freq Sweep Mode\n");
-        }
-        return;
-      }
+      iir.s[k].b0 = Serial.parseInt(); iir.s[k].b1 = Serial.parseInt(); iir.s[k].b2 = Serial.parseInt();
+      iir.s[k].a1 = Serial.parseInt(); iir.s[k].a2 = Serial.parseInt();
     }
+    else iir.s[k] = {1L << 28, 0, 0, 0, 0}; // unused sections pass the signal straight through
+  }
+  for (byte k = 0; k < sections; k++) if (!NoiseBiquadStable(&iir.s[k]))
+  {
+    Serial.print("   IIR section "); Serial.print(k + 1); Serial.println(" is unstable - |a2| and |a1| - a2 must be below 1.0 (268435456) - filter not changed\n");
+    return;
   }
+  float peak = NoiseIirPeakGain(&iir, sections); // up to 1/2 a Sec with interrupts on - the noise keeps playing
+  if (peak == 0 || peak >= NOISE_IIR_GAIN_MAX)
+  {
+    if (peak == 0) Serial.println("   IIR filter still ringing after 16384 samples - too close to unstable - filter not changed\n");
+    else {Serial.print("   IIR filter peak gain is "); Serial.print(peak, 1); Serial.print(" - it must be below "); Serial.print(NOISE_IIR_GAIN_MAX, 0); Serial.println(" to leave headroom - filter not changed\n");}
+    return;
+  }
+  noInterrupts(); // swap in the new sections between DMA blocks, each starting from silence
+  UserIir = iir;
+  for (byte k = 0; k < NOISE_BAND_SECTIONS; k++) Noise.bandState[k] = NoiseBiquadState();
+  Noise.band = &UserIir;
+  NoiseBand = NOISE_BAND_USER;
+  interrupts();
+  Serial.print("   IIR noise filter with "); Serial.print(sections); Serial.print(" biquad sections - peak gain "); Serial.println(peak, 1); Serial.println("");
 }
 
-void PrintSyncedWaveFreq()
+void PrintFirBudget() // measure the FIR noise generator's cost & print the max taps that fit at each noise sample rate
 {
-  if      (ActualWaveFreq < 1)       {
-    Serial.print(ActualWaveFreq * 1000, 5);
-    Serial.print(" mHz");
+  static const uint16_t divisors[] = {84, 105, 280, 420}; // 500, 400, 150 & 100 kHz
+  NoiseFir fir;            // scratch copies on the stack, so the noise being played isn't disturbed
+  NoiseGenerator gen = Noise;
+  NoiseRng rng;
+  NoiseRngSeed(&rng, 1);
+  NoiseRngSource white = {&rng};
+  uint16_t out[64];
+  uint32_t cycles[2] = {0xFFFFFFFF, 0xFFFFFFFF};
+  for (uint16_t k = 0; k < NOISE_FIR_TAPS; k++) fir.h[k] = 256;
+  for (byte run = 0; run < 8; run++) for (byte j = 0; j < 2; j++) // time 64 samples with 0 taps, then with NOISE_FIR_TAPS taps - interrupts stay on (the noise keeps playing), so the fastest of 8 runs is the one no interrupt ran in
+  {
+    fir.taps = j ? NOISE_FIR_TAPS : 0;
+    uint32_t startCycles = DWT->CYCCNT;
+    NoiseFirRender(&gen, &fir, white, out, 64, NOISE_UNITY_GAIN);
+    cycles[j] = min(cycles[j], DWT->CYCCNT - startCycles);
   }
-  else if (ActualWaveFreq < 1000)    {
-    Serial.print(ActualWaveFreq, 5);
-    Serial.print(" Hz");
+  float perSample = cycles[0] / 64.0;                                 // white noise, history, EQ, gain & dither
+  float perTap    = (cycles[1] - cycles[0]) / (64.0 * NOISE_FIR_TAPS);
+  Serial.print("   FIR cost: "); Serial.print(perSample, 1); Serial.print(" cycles per sample + "); Serial.print(perTap, 2); Serial.println(" per tap (measured)");
+  Serial.print("   Max taps for "); Serial.print(NOISE_FIR_BUDGET); Serial.println("% CPU load:");
+  for (byte i = 0; i < 4; i++)
+  {
+    float budget = 2.0 * divisors[i] * NOISE_FIR_BUDGET / 100; // 84 MHz / (42 MHz / divisor) cycles per sample
+    int maxTaps = constrain(int((budget - perSample) / perTap), 0, NOISE_FIR_TAPS);
+    Serial.print("     "); Serial.print(42000 / divisors[i]); Serial.print(" kHz: "); Serial.print(maxTaps);
+    if (divisors[i] == NoiseDivisor) Serial.print(" <- current rate");
+    if (maxTaps == NOISE_FIR_TAPS) Serial.print(" (all)");
+    Serial.println("");
   }
-  else                           {
-    Serial.print(ActualWaveFreq / 1000, 5);
-    Serial.print(" kHz");
+  if (UserFir.taps)
+  {
+    Serial.print("   Current FIR filter: "); Serial.print(100 * (perSample + perTap * UserFir.taps) / (2 * NoiseDivisor), 0); Serial.println("% CPU load (estimated - nl measures it)");
   }
+  Serial.println("");
 }
 
-void PrintSyncedWavePeriod()
+void SetNoiseSeed(uint32_t seed) // select frozen noise with this seed - takes effect next time noise starts
 {
-  float AnaPeriod = 1000 / ActualWaveFreq; // in mSeconds
-  if (TargetWaveDuty == 0)
+  NoiseSeed = seed;
+  NoiseSource = 1;
+}
+
+void StopNoise() // stop noise generation & restore the DAC & timer set-up for the analogue wave
+{
+  NVIC_DisableIRQ(TC2_IRQn); // disable noise IRQ
+  TC_Stop(TC0, 2);           // stop noise timer (also stops it triggering the DAC when in DMA noise mode)
+  if (NoiseBlockMode) DACC->DACC_PTCR = DACC_PTCR_TXTDIS; // stop streaming noise blocks
+  NoiseBlockMode = LOW;
+  if (DdsMode) SetDdsWave(0); // analogue wave resumes in DDS blocks
+  else if (FastMode >= 0)
   {
-    if (SquareWaveSync) AnaPulseWidth = 0.000048; // in mSeconds
-    else AnaPulseWidth = 0.000350; // in mSeconds
+    TC_setup();
+    dac_setup();
   }
-  else if (TargetWaveDuty >= 100)
+  else
+  {
+    TC_setup2();
+    dac_setup2(); // remove DMA noise trigger & interrupt from DAC
+  }
+}
+
+void ToneBankSetup() // calculate the full scale tones (integer sine) & fill both buffer sets at 100%
+{
+  for (byte t = 0; t < TONES; t++)
+  {
+    uint32_t cycles = 1 << t; // whole cycles per buffer: 4kHz = 1, 8kHz = 2, 16kHz = 4, 32kHz = 8
+    for (uint16_t i = 0; i < TONEBLOCK; i++) ToneWave[t][i] = SinQ15(((uint64_t) i * cycles << 32) / TONEBLOCK); // each cycle starts at 0 degrees, so tones start & stop at mid-scale
+  }
+  SetToneAmp(1000000); // fills one set
+  SetToneAmp(1000000); // & then the other
+}
+
+void SetToneAmp(uint32_t amp) // change the tone level (1000000 = 100%) without disturbing the buffer playing: scales the tones into the other buffer set (estimated 40 uSecs), then swaps sets
+{
+  ToneAmpPending = ToneBankMode && ToneOldSet; // only if the level was changed again within 0.5 mSecs - rather than wait here (forever if the DMA has stopped)
+  ToneAmpNext = amp;
+  if (ToneAmpPending) return;
+  byte set = !ToneSet;
+  int32_t a = ((uint64_t) min(amp, 1000000UL) * (HALFRESOL - 1) * 65536 + 500000) / 1000000; // peak in DAC steps, Q16
+  for (uint16_t i = 0; i < TONEBLOCK; i++) ToneBank[set][0][i] = HALFRESOL;
+  for (byte t = 0; t < TONES; t++)
+  {
+    for (uint16_t i = 0; i < TONEBLOCK; i++) ToneBank[set][t + 1][i] = HALFRESOL + (int32_t) (((int64_t) ToneWave[t][i] * a + (1 << 30)) >> 31);
+  }
+  ToneSet = set;  // DACC_Handler queues the new level from the next buffer on - always at a buffer boundary (mid-scale)
+  ToneOldSet = 2; // the DMA buffer playing & the one queued may be from the old set
+  ToneAmp = amp;
+}
+
+void StartToneBank() // play the tone bank from TC0 channel 0 & DMA, starting with silence - SelectTone() then switches tones with no recalculating
+{
+  if (ToneBankMode) return;
+  NVIC_DisableIRQ(TC0_IRQn); // slow mode interrupt not used
+  NVIC_DisableIRQ(DACC_IRQn);
+  ToneSelect = 0;
+  ToneQueued = 0;
+  ToneOldSet = 0;
+  DdsBlockMode = LOW;
+  ToneBankMode = HIGH;
+  dac_setup4(ToneBank[ToneSet][0], ToneBank[ToneSet][0], TONEBLOCK); // silence
+  TC_setup6(TONE_DIVISOR);
+}
+
+void SelectTone(uint16_t kHz) // play the 4, 8, 16 or 32 kHz tone - any other freq selects silence. Starts & stops at OnsetPhase in the next buffer (within 0.5 mSecs)
+{
+  byte tone = 0;
+  for (byte i = 0; i < TONES; i++) if (kHz == (4 << i)) tone = i + 1;
+  OnsetReady = LOW;  // ToneOnset() reports this tone's onset, not an earlier one
+  ToneSelect = tone; // only a buffer pointer changes - DACC_Handler queues it after the buffer already queued
+}
+
+void StopToneBank() // stop the tone bank & restore the DAC & timer set-up for the analogue wave
+{
+  if (!ToneBankMode) return;
+  DACC->DACC_PTCR = DACC_PTCR_TXTDIS; // stop streaming tone buffers
+  ToneBankMode = LOW;
+  if (DdsMode) SetDdsWave(0); // analogue wave resumes in DDS blocks
+  else if (FastMode >= 0)
+  {
+    TC_setup();
+    dac_setup();
+  }
+  else
+  {
+    TC_setup2();
+    dac_setup2();
+  }
+}
+
+void SetOnsetPhase(float degrees) // phase of the sine at which tones start & stop (0 = rising zero crossing, 180 = falling) - to the nearest sample for tone bank tones
+{
+  degrees = fmod(degrees, 360);
+  if (degrees < 0) degrees += 360;
+  OnsetPhase = degrees;
+  Serial.print("   Onset Phase: "); Serial.print(degrees, 1); Serial.print(" degrees - tone bank");
+  for (byte t = 0; t < TONES; t++)
+  {
+    float perCycle = float(TONEBLOCK) / (1 << t); // samples per cycle: 100, 50, 25 & 12.5
+    ToneOnsetOffset[t] = (uint16_t) (degrees / 360 * perCycle + 0.5) % TONEBLOCK;
+    Serial.print(t ? ", " : " "); Serial.print(ToneOnsetOffset[t] * 360 / perCycle, 1); // actual phase
+  }
+  Serial.println(" degrees\n");
+  float wave = fmod(degrees + 270, 360); // position in WaveFull & WaveFull2 (from the +ve peak at 90 degrees)
+  noInterrupts();
+  DdsOnsetHalf  = wave >= 180;
+  DdsOnsetPhase = (uint32_t) ((wave - 180 * DdsOnsetHalf) / 180 * 4294967296.0);
+  interrupts();
+}
+
+uint32_t DacSampleNow() // index (DacQueued count) of the sample the DAC is converting now - to within the DAC's FIFO (4 samples)
+{
+  uint32_t left, next;
+  noInterrupts(); // DacQueued isn't updated while reading
+  do // read again if the DMA moved its next buffer into the current one between the reads
+  {
+    next = DACC->DACC_TNCR;
+    left = DACC->DACC_TCR + next;
+  }
+  while (DACC->DACC_TNCR != next);
+  uint32_t queued = DacQueued;
+  interrupts();
+  return queued - left;
+}
+
+bool ToneOnset(uint32_t *sample) // true (once) when a tone's start has been scheduled - sample is the DacQueued index of its first sample (compare with DacSampleNow() when the TTL was set)
+{
+  if (!OnsetReady) return false;
+  noInterrupts();
+  *sample = OnsetSample;
+  OnsetReady = LOW;
+  interrupts();
+  return true;
+}
+
+uint32_t BlockSampleRate() // DAC sample rate (per DAC) of noise, tone bank or DDS blocks - 0 if the analogue wave isn't played in blocks
+{
+  if (NoiseBlockMode) return 42000000 / NoiseDivisor;
+  if (ToneBankMode)   return 42000000 / TONE_DIVISOR;
+  if (DdsBlockMode)   return 42000000 / DdsDivisor / (DdsStereo ? 2 : 1);
+  return 0;
+}
+
+const uint16_t *GateShapeRise(byte shape) // rise table of a gate shape (GATE_LINEAR etc) - cos^2 if out of range
+{
+  return GateShapes.shape[shape < GATE_SHAPES ? shape : GATE_COS2].v;
+}
+
+static uint32_t GatePosAt(const uint16_t *table, uint16_t level) // first position in a rise table at or above level (binary search - the tables only rise)
+{
+  uint16_t lo = 0, hi = GATE_POINTS;
+  while (lo < hi)
+  {
+    uint16_t mid = (lo + hi) / 2;
+    if (table[mid] < level) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo == GATE_POINTS ? 0xFFFFFFFF : (uint32_t) lo << 22;
+}
+
+void SetGate(float rampMs, byte rise, byte fall) // gate rise & fall time (mSecs) & shapes (GATE_COS2 etc, gateshapes.h): the gate closes (silence) until StartGate() - 0 mSecs turns the gate off, so blocks are played untouched
+{
+  noInterrupts();
+  GateState = rampMs > 0 ? GATE_CLOSED : GATE_OFF;
+  GatePos = 0;
+  GateRiseShape = GateShapeRise(rise);
+  GateFallShape = GateShapeRise(fall);
+  interrupts();
+  GateRamp = max(rampMs, 0.0f);
+}
+
+bool StartGate(uint32_t durationMs) // rise, full level & fall, together lasting durationMs (mSecs) - 0 = full level until GateRelease(). Times are counted in samples from the next block filled, so they're exact to the sample. Returns false if there's no gate
+{
+  uint32_t rate = BlockSampleRate();
+  if (GateRamp <= 0 || !rate) return false; // gate off - or the analogue wave not in blocks (FastMode or slow mode), so nothing to gate
+  uint32_t ramp = max((uint32_t) (GateRamp * rate / 1000 + 0.5), 1UL); // samples
+  uint64_t samples = (uint64_t) durationMs * rate / 1000;
+  noInterrupts();
+  GateInc  = min(4294967296ULL / ramp, 4294967295ULL);
+  GateHold = durationMs ? (uint32_t) min(samples > 2ULL * ramp ? samples - 2ULL * ramp : 0ULL, 4294967294ULL) : GATE_HOLD_ON;
+  if (GateState == GATE_CLOSED) GatePos = 0;
+  else if (GateState == GATE_FALL) GatePos = GatePosAt(GateRiseShape, GateFallShape[GatePos >> 22]); // rises from the level it has fallen to - the shapes may differ
+  if (GateState != GATE_OPEN) GateState = GATE_RISE;
+  interrupts();
+  return true;
+}
+
+void GateRelease() // start the fall now - or as soon as the rise is complete
+{
+  noInterrupts();
+  GateHold = 0;
+  interrupts();
+}
+
+void CloseGate() // silence straight away (no fall) - as a sound is stopped
+{
+  noInterrupts();
+  if (GateState != GATE_OFF) GateState = GATE_CLOSED;
+  GatePos = 0;
+  interrupts();
+}
+
+bool GateClosed() // true once the fall is complete (or the gate is off)
+{
+  return GateState == GATE_CLOSED || GateState == GATE_OFF;
+}
+
+bool ToneSilent() // true once the tone bank has queued its stop (or isn't playing) - every block from now on is silence, so the gate can be turned off
+{
+  return !ToneBankMode || (!ToneSelect && !ToneQueued);
+}
+
+static void DdsIncrements(uint32_t (&inc)[2], double freq, double rate, float duty, bool oneHalf) // phase per sample in each wave half for 1 DDS channel
+{
+  double cycleInc = freq * 4294967296.0 / rate; // phase per sample if 1 wave half lasted the whole cycle
+  if (oneHalf) inc[0] = inc[1] = constrain(round(cycleInc), 1, 4294967295.0);
+  else
+  {
+    inc[0] = constrain(round(cycleInc * 100 / duty), 1, 4294967295.0);         // 1st wave half lasts duty % of the cycle
+    inc[1] = constrain(round(cycleInc * 100 / (100 - duty)), 1, 4294967295.0); // 2nd wave half the rest
+  }
+}
+
+void SetDdsWave(bool show) // DDS engine: phase increments for the target freq & duty-cycle, starting the engine if it isn't running. Freq steps are DDS rate / 2^32 (0.23 mHz at 1 MHz)
+{
+  bool highFreq = TargetWaveFreq > DDS_HF_FREQ;
+  uint16_t divisor = highFreq ? DDS_HF_DIVISOR : DDS_DIVISOR;
+  double rate = 42000000.0 / divisor;
+  if (DdsStereo) rate /= 2; // 2 channel mode: each trigger converts 1 sample, for DAC0 & DAC1 in turn
+  double freq[2] = {TargetWaveFreq, DdsStereo ? max(TargetWaveFreq + DdsOffset, 0.001) : TargetWaveFreq}; // DAC0, DAC1
+  float duty = TargetWaveDuty;
+  bool oneHalf = (duty <= 0 || duty >= 100);
+  if (!oneHalf)
+  {
+    float dutyLimit = 100 * max(freq[0], freq[1]) / rate; // 1 sample
+    duty = constrain(duty, dutyLimit, 100 - dutyLimit);
+  }
+  uint32_t inc[2][2]; // [channel][wave half]
+  DdsIncrements(inc[0], freq[0], rate, duty, oneHalf);
+  DdsIncrements(inc[1], freq[1], rate, duty, oneHalf);
+  noInterrupts(); // DACC_Handler sees all or none of the change
+  for (byte ch = 0; ch < 2; ch++)
+  {
+    Dds[ch].Increment[0] = inc[ch][0];
+    Dds[ch].Increment[1] = inc[ch][1];
+    Dds[ch].Ratio[0] = min(((uint64_t) inc[ch][0] << 16) / inc[ch][1], 4294967295ULL);
+    Dds[ch].Ratio[1] = min(((uint64_t) inc[ch][1] << 16) / inc[ch][0], 4294967295ULL);
+    if (oneHalf) Dds[ch].Half = (duty <= 0); // 0% = 2nd (neg going) wave half only, 100% = 1st wave half only
+  }
+  DdsOneHalf = oneHalf;
+  DdsInterpolate = highFreq;
+  interrupts();
+  double samples[2] = {4294967296.0 / inc[0][0], 4294967296.0 / inc[0][1]}; // samples per wave half
+  if (oneHalf)
+  {
+    ActualWaveFreq = rate / samples[0];
+    ActualWaveDuty = (duty <= 0) ? 0 : 100;
+  }
+  else
+  {
+    ActualWaveFreq = rate / (samples[0] + samples[1]);
+    ActualWaveDuty = 100 * samples[0] / (samples[0] + samples[1]);
+  }
+  if (!DdsBlockMode)
+  {
+    DdsDivisor = divisor;
+    StartDds();
+  }
+  else if (divisor != DdsDivisor) // crossing DDS_HF_FREQ - change sample rate
+  {
+    DdsDivisor = divisor;
+    TC_setup6(DdsDivisor);
+  }
+  if (show)
+  {
+    Serial.print("   Analogue Wave Freq: ");
+    PrintSyncedWaveFreq(); Serial.print(", Target: ");
+    Serial.print(TargetWaveFreq, 3);
+    Serial.print(" Hz (DDS at "); Serial.print(rate / 1000000, DdsStereo ? 2 : 1); Serial.print(DdsStereo ? " MHz per DAC)\n" : " MHz)\n");
+    if (DdsStereo)
+    {
+      double freq1 = oneHalf ? rate * inc[1][0] / 4294967296.0 : rate / (4294967296.0 / inc[1][0] + 4294967296.0 / inc[1][1]);
+      Serial.print("   DAC1 Wave Freq: "); Serial.print(freq1, 3); Serial.print(" Hz, "); Serial.print(freq1 - ActualWaveFreq, 3); Serial.println(" Hz above DAC0");
+    }
+    Serial.print("   Analogue Wave Period: ");
+    PrintSyncedWavePeriod();
+    Serial.print("   Analogue Wave Duty-cycle: "); Serial.print(ActualWaveDuty); Serial.println(" %\n");
+  }
+}
+
+void StartDds() // start streaming the analogue wave in DDS blocks from TC0 channel 0 & DMA - SetDdsWave() sets the freq first
+{
+  NVIC_DisableIRQ(TC0_IRQn); // slow mode interrupt not used
+  NVIC_DisableIRQ(DACC_IRQn);
+  for (byte ch = 0; ch < 2; ch++) // both DACs start in phase, at OnsetPhase
+  {
+    if (DdsOneHalf) Dds[ch].Phase = 0;
+    else
+    {
+      Dds[ch].Phase = DdsOnsetPhase;
+      Dds[ch].Half  = DdsOnsetHalf;
+    }
+  }
+  OnsetSample = 0; // 1st sample of the 1st block
+  OnsetReady = HIGH;
+  SCB->ICSR = SCB_ICSR_PENDSVCLR_Msk; // no refill left over from the last time DDS played
+  DdsFillDue = LOW;
+  DdsBlockHalf = 0; // DdsBlock[0] plays first, so it's the next to be queued again
+  DdsFillHalf = 0;
+  FillDdsBlock(DdsBlock[0], DDSBLOCK);
+  FillDdsBlock(DdsBlock[1], DDSBLOCK);
+  ToneBankMode = LOW;
+  DdsBlockMode = HIGH;
+  dac_setup4(DdsBlock[0], DdsBlock[1], DDSBLOCK);
+  TC_setup6(DdsDivisor);
+}
+
+void StopDds() // stop the DDS engine & restore the DAC & timer set-up for FastMode / slow mode
+{
+  if (!DdsBlockMode) return;
+  DACC->DACC_PTCR = DACC_PTCR_TXTDIS; // stop streaming DDS blocks
+  DdsBlockMode = LOW;
+  if (FastMode >= 0)
+  {
+    TC_setup();
+    dac_setup();
+  }
+  else
+  {
+    TC_setup2();
+    dac_setup2();
+  }
+}
+
+void RestartDds() // restart the DDS engine with the DAC & sample rate set-up for 1 or 2 channels
+{
+  if (!DdsBlockMode) return;
+  DACC->DACC_PTCR = DACC_PTCR_TXTDIS;
+  DdsBlockMode = LOW; // so SetDdsWave() starts it again
+  SetDdsWave(1);
+}
+
+void ToggleDdsStereo() // 2 channel mode: DAC1 plays the DDS wave too, DdsOffset Hz above DAC0 - interleaved samples in 1 DMA buffer, so no more interrupts than 1 channel
+{
+  DdsStereo = !DdsStereo;
+  if (DdsStereo)
+  {
+    Serial.print("   2 Channel Mode is ON - DAC1 plays the analogue wave "); Serial.print(DdsOffset, 3);
+    Serial.println(" Hz above DAC0 (set with xo). DDS sample rate per DAC is halved");
+  }
+  else Serial.println("   2 Channel Mode is OFF - DAC0 only");
+  if (DdsStereo && !DdsMode) ToggleDdsMode(); // needs the DDS engine
+  else RestartDds();
+}
+
+void SetDdsOffset(double offset) // DAC1 freq - DAC0 freq in 2 channel mode (Hz) - the beat freq of binaural stimuli
+{
+  DdsOffset = offset;
+  Serial.print("   DAC1 Freq Offset: "); Serial.print(DdsOffset, 3); Serial.println(" Hz");
+  if (!DdsStereo) Serial.println("   Takes effect in 2 Channel Mode (B)\n");
+  else if (DdsBlockMode) SetDdsWave(1);
+}
+
+void ToggleDdsMode()
+{
+  DdsMode = !DdsMode;
+  if (DdsMode) Serial.println("   DDS Mode is ON - analogue wave at a fixed sample rate (interpolated above 10kHz), freq steps of 0.23 mHz. No synchronized square wave");
+  else Serial.println("   DDS Mode is OFF");
+  if (WaveShape == 4) return; // takes effect when noise is deselected
+  if (DdsMode)
+  {
+    if (SquareWaveSync) ToggleSquareWaveSync(0); // change to Unsychronized Square Wave - the DDS engine has no per half cycle interrupt to sync it
+    SetWaveFreq(1);
+  }
+  else
+  {
+    StopDds();
+    SetWaveFreq(1);
+    CalculateWaveDuty(1);
+    CreateNewWave();
+  }
+}
+
+void PrintCpuLoad() // measure CPU time used by the noise / DMA interrupt handlers over 1/4 of a second
+{
+  bool slowMode = WaveShape != 4 && !DdsBlockMode && !ToneBankMode && FastMode < 0;
+  if (slowMode) SelectTc0Handler(1); // time the TC0_Handler variant for the current mode
+  uint32_t startCycles = DWT->CYCCNT;
+  uint32_t startIsrCycles = IsrCycles;
+  uint32_t startIsrCount  = IsrCount;
+  delay(250);
+  uint32_t cycles    = DWT->CYCCNT - startCycles;
+  uint32_t isrCount  = IsrCount - startIsrCount;
+  if (slowMode) SelectTc0Handler();
+  uint32_t isrCycles = IsrCycles - startIsrCycles + (isrCount * 24); // add 12 cycles for entering & 12 for leaving each interrupt
+  float    load      = 100.0 * isrCycles / cycles;
+  if (WaveShape == 4)
+  {
+    Serial.print("   Noise mode: "); Serial.println(NoiseDMA ? "DMA blocks" : "per-sample interrupt");
+    Serial.print("   Noise sample rate: "); Serial.print(42000000 / NoiseDivisor); Serial.println(" Hz");
+    Serial.print("   TRNG read before ready: "); Serial.print(TrngEarlyReads); Serial.println(" times since start-up");
+    if (NoiseDMA) {Serial.print("   Noise blocks refilled late: "); Serial.print(NoiseFillsLate); Serial.println(" times since start-up (should be 0 - if not, raise NOISE_DIVISOR)");}
+  }
+  else
+  {
+    Serial.print("   Analogue wave DMA: ");
+    if      (DdsBlockMode)
+    {
+      Serial.print("DDS blocks of "); Serial.print(DDSBLOCK); Serial.println(DdsStereo ? " samples per DAC (2 channels interleaved)" : " samples");
+      Serial.print("   DDS blocks refilled late: "); Serial.print(DdsFillsLate); Serial.println(" times since start-up (should be 0 - if not, raise DDS_DIVISOR)");
+    }
+    else if (ToneBankMode) Serial.println("tone bank buffers");
+    else if (FastMode < 0)
+    {
+      Serial.print("none - slow mode interrupt per sample: InterruptMode "); Serial.print(InterruptMode); Serial.print(", exact freq "); Serial.print(ExactFreqDutyNot50 ? 2 : ExactFreqMode);
+      Serial.print(", 0 or 100% duty "); Serial.print(MinOrMaxWaveDuty); Serial.print(", sync "); Serial.println(SquareWaveSync);
+      if (isrCount > 0) { Serial.print("   Cycles per interrupt: "); Serial.print((float) isrCycles / isrCount, 1); Serial.println(" (including entry, exit & the timing call)"); }
+    }
+    else if (MultiCycleMode) { Serial.print(MultiCycles[MultiSet]); Serial.println(" whole cycles per buffer"); }
+    else Serial.println("half cycle buffers (synchronized square wave)");
+  }
+  Serial.print("   Interrupts per second: "); Serial.println(isrCount * 4);
+  Serial.print("   Interrupt CPU load: "); Serial.print(load, 2); Serial.println(" %");
+  Serial.print("   CPU headroom: "); Serial.print(100 - load, 2); Serial.println(" %\n");
+}
+
+void ToggleExactFreqMode()
+{
+  SyncDelay = 0; // remove square wave sync delay for stability in case of sudden change to high freq
+  ExactFreqMode = !ExactFreqMode;
+  if (ExactFreqMode) Serial.println("   Exact Freq Mode is ON ");
+  else Serial.println("   Exact Freq Mode is OFF");
+  if (ExactFreqMode && TargetWaveDuty != 50) ExactFreqDutyNot50 = 1;
+  else ExactFreqDutyNot50 = 0;
+  SetWaveFreq(1);
+  SyncDelay = (TimerCounts - Delay1) * Delay2 * max((Delay3 / (abs(ActualWaveDuty - 50.0) + Delay3)), int(MinOrMaxWaveDuty)); // re-apply square wave sync delay
+}
+
+void ToggleSquareWaveSync(bool exitingNoise) // exitingNoise: 1 = exiting noise selection. 0 = normal operation.
+{
+  if (!SquareWaveSync && DdsMode && (WaveShape != 4 || exitingNoise) && TimerMode == 0) // the DDS engine has no per half cycle interrupt to sync with - as with noise, stay unsynchronized
+  {
+    Serial.println("   Cannot synchronize the Square Wave in DDS Mode - type E to leave DDS Mode first\n");
+  }
+  else if (((!SquareWaveSync && WaveShape != 4) || (exitingNoise && OldSquareWaveSync)) && TimerMode == 0) // toggle SquareWaveSync to ON if Noise not selected & Timer is off
+  {
+    NVIC_DisableIRQ(TC1_IRQn);
+    PWMC_DisableChannel(PWM_INTERFACE, g_APinDescription[7].ulPWMChannel);
+    pinMode(7, INPUT);
+    PIO_Configure(PIOC, PIO_PERIPH_B, PIO_PC28B_TIOA7, PIO_DEFAULT); // enable pin 3
+    SquareWaveSync = HIGH; // start Synchronized Square wave
+    MinMaxDuty = 4; // allow min (& max) duty-cycle of 4 samples
+    CalculateWaveDuty(0);
+    CreateNewWave();
+    WavePolarity();
+    if (WaveShape != 4) Serial.println("   Square Wave is Synchronized with Analogue Wave\n");
+  }
+  else if (SquareWaveSync && TimerMode == 0) // toggle SquareWaveSync to OFF if Timer is off (if timer is ON do nothing)
+  {
+    SquareWaveSync = LOW; // stop Synchronized Square wave
+    if (TargetFreq < 163)
+    {
+      pinMode(7, INPUT); // re-enable pin after stopping
+      TC_setup3();
+    }
+    else
+    {
+      REG_PIOC_PER |= PIO_PER_P28; // PIO takes control of pin 3 from peripheral - similar to pinMode(3, OUTPUT) but faster
+      REG_PIOC_ODR |= PIO_ODR_P28; // PIO disables pin 3 (C28) - similar to pinMode(3, INPUT)
+      SetPWM(7, Period, Pulse); // PWMC_EnableChannel(PWM_INTERFACE, g_APinDescription[7].ulPWMChannel);
+    }
+    MinMaxDuty = 1; // allow min (& max) duty-cycle of 1 sample
+    CalculateWaveDuty(ExactFreqMode);
+    CreateNewWave();
+    if (WaveShape != 4) Serial.println("   Square Wave is Unsynchronized\n");
+  }
+  if (ExactFreqMode) SetWaveFreq(0); // ensures exact freq maintained
+}
+
+void EnterSweepMode()
+{
+  if (SweepMode == 0 && TimerMode == 0)
+  {
+    if (!UsingGUI)
+    {
+      Serial.println("\n         ************ SWEEP FREQUENCY MODE ************");
+      Serial.println("\n            (Type ? for Sweep Menu   Type q to quit)\n");
+      Serial.print("   Current Settings are:\n\tHighest freq = "); Serial.print(SweepMaxFreq); Serial.print(" Hz  \tRise time = "); Serial.print(SweepRiseTime); Serial.print(" Sec\n  \tLowest freq  = "); Serial.print(SweepMinFreq); Serial.print(" Hz  \tFall time = "); Serial.print(SweepFallTime); Serial.println(" Sec");
+      //             Serial.println(String("   Current Settings are:\n\tHighest freq = ") + SweepMaxFreq + String(" Hz  \tRise time = ") + SweepRiseTime + String(" Sec\n  \tLowest freq  = ") + SweepMinFreq + String(" Hz  \tFall time = ") + SweepFallTime + String(" Sec"));
+      if (SweepMinFreq == 0 || SweepMinFreq >= SweepMaxFreq || SweepRiseTime + SweepFallTime == 0)
+      {
+        Serial.println("   These setting are incorrect and must be changed.");
+        if (SweepMinFreq == 0 ) Serial.println("   The Lowest freq is set to zero!");
+        if (SweepMinFreq >= SweepMaxFreq) Serial.println("   The Highest freq is not higher than the Lowest freq!");
+        if (SweepRiseTime + SweepFallTime == 0) Serial.println("   Both Rise and Fall times are set to zero!");
+        Serial.println("\n   To make changes enter the desired value followed by:\n\tH for Highest freq in Hz\tR for Rise time in seconds\n\tL for Lowest freq  in Hz\tF for Fall time in seconds\n   For example: 20L 20000H 20R 20F\n");
+      }
+      else Serial.println("\n   To make changes enter the desired value followed by:\n\tH for Highest freq in Hz\tR for Rise time in seconds\n\tL for Lowest freq  in Hz\tF for Fall time in seconds\n   For example: 20L 20000H 20R 20F\n\n               Type r to start the sweep Running\n\n          ***** Type r again to stop the sweep! *****\n");
+    }
+    else Serial.println("SweepOn");
+    SweepMode = 1;
+  }
+}
+
+void ExitSweepMode()
+{
+  if (SweepMode > 0)
+  {
+    SweepMode = 0;
+    if (UsingGUI) Serial.println("SweepOff");
+    else Serial.println("           *****  Exited Sweep Frequency Mode  *****\n");
+  }
+}
+
+void SweepFreq()
+{
+  float oldFreq  = TargetFreq;
+  float oldWaveFreq = TargetWaveFreq;
+  int   SweepUpdatePeriod = 25; // change freq every SweepUpdatePeriod milliseconds
+  float RiseIncrement = pow(float(SweepMaxFreq) / SweepMinFreq, 1 / (float(SweepRiseTime) / (SweepUpdatePeriod * 0.001))); // proportional freq increase required each SweepUpdatePeriod
+  float FallIncrement = pow(float(SweepMinFreq) / SweepMaxFreq, 1 / (float(SweepFallTime) / (SweepUpdatePeriod * 0.001))); // proportional freq decrease required each SweepUpdatePeriod
+  float TargetSweepFreq = SweepMinFreq;
+  float SweepIncrement = RiseIncrement;
+  unsigned long SweepUpdateTime = millis() + SweepUpdatePeriod;
+  while (1)
+  {
+    if (TargetSweepFreq >= SweepMaxFreq) SweepIncrement = FallIncrement;
+    else if (TargetSweepFreq <= SweepMinFreq) SweepIncrement = RiseIncrement;
+    if (millis() >= SweepUpdateTime)
+    {
+      SweepUpdateTime = millis() + SweepUpdatePeriod; // set next SweepUpdateTime
+      if (SweepFallTime == 0 && TargetSweepFreq >= SweepMaxFreq) TargetSweepFreq = SweepMinFreq;
+      else if (SweepRiseTime == 0 && TargetSweepFreq <= SweepMinFreq) TargetSweepFreq = SweepMaxFreq;
+      else TargetSweepFreq *= SweepIncrement;
+      if (Control > 0)
+      {
+        TargetWaveFreq = min(TargetSweepFreq, 100000);
+        SetWaveFreq(0);
+        if (Control > 1 && !UsingGUI) Serial.println();
+        if (!UsingGUI) Serial.print("\n   ");
+        if (UsingGUI) Serial.print("AAF ");
+        PrintSyncedWaveFreq();
+      }
+      if (Control != 1)
+      {
+        TargetFreq = TargetSweepFreq;
+        SetFreqAndDuty(1, 1);
+        if (UsingGUI) Serial.print("SAF ");
+        else Serial.print("\n   ");
+        PrintUnsyncedSqWaveFreq();
+      }
+    }
+    if (Serial.available() > 0 || !digitalRead(21)) // if signalled to stop Running, by serial or switch
+    {
+      if (digitalRead(21)) UserChars[0] = Serial.read(); // if by serial
+      if (UserChars[0] == 'r' || !digitalRead(21)) // if signalled to stop Running, by serial or switch
+      {
+        SweepMode = 1;
+        if (Control > 0) // return to freq before sweep
+        {
+          TargetWaveFreq = oldWaveFreq;
+          FreqIncrement = min(TargetWaveFreq, 100000) * 21475;
+          SetWaveFreq(0);
+          if (UsingGUI) Serial.print("AAF ");
+          else Serial.print("\n   ");
+          PrintSyncedWaveFreq();
+        }
+        if (Control != 1) // return to freq before sweep
+        {
+          TargetFreq = oldFreq;
+          SetFreqAndDuty(1, 1);
+          if (UsingGUI) Serial.print("SAF ");
+          else Serial.print("\n   ");
+          PrintUnsyncedSqWaveFreq();
+        }
+        if (!UsingGUI)
+        {
+          Serial.println("\n   Sweep stopped\n");
+          Serial.print("   To repeat this freq sweep later, the following string can be entered:\n\n   "); // indent next line
+          Serial.print(SweepMinFreq); Serial.print("L"); Serial.print(SweepMaxFreq); Serial.print("H"); Serial.print(SweepRiseTime); Serial.print("R"); Serial.print(SweepFallTime); Serial.println("F  (followed by 'r' to start the sweep running)");
+          //        Serial.println(SweepMinFreq + String("L") + SweepMaxFreq + String("H") + SweepRiseTime + String("R") + SweepFallTime + String("Fr"));
+          Serial.println("\n               Type q to quit the Freq Sweep Mode\n");
+        }
+        return;
+      }
+    }
+  }
+}
+
+void PrintSyncedWaveFreq()
+{
+  if      (ActualWaveFreq < 1)       {
+    Serial.print(ActualWaveFreq * 1000, 5);
+    Serial.print(" mHz");
+  }
+  else if (ActualWaveFreq < 1000)    {
+    Serial.print(ActualWaveFreq, 5);
+    Serial.print(" Hz");
+  }
+  else                           {
+    Serial.print(ActualWaveFreq / 1000, 5);
+    Serial.print(" kHz");
+  }
+}
+
+void PrintSyncedWavePeriod()
+{
+  float AnaPeriod = 1000 / ActualWaveFreq; // in mSeconds
+  if (TargetWaveDuty == 0)
+  {
+    if (SquareWaveSync) AnaPulseWidth = 0.000048; // in mSeconds
+    else AnaPulseWidth = 0.000350; // in mSeconds
+  }
+  else if (TargetWaveDuty >= 100)
   {
     if (SquareWaveSync) AnaPulseWidth = AnaPeriod - 0.000096; // in mSeconds
     else AnaPulseWidth = AnaPeriod - 0.000350; // in mSeconds
@@ -3042,6 +3979,7 @@ int freqToTc(float freq_hz)
 
 void WavePolarity() // ensures the same wave polarity is maintained (relative to square wave)
 {
+  if (ToneBankMode || DdsBlockMode) return; // Wave0 to Wave3 not in use
   if (FastMode == 0)
   {
     DACC->DACC_TPR  =  (uint32_t)  Wave0[0];      // DMA buffer
@@ -3071,14 +4009,23 @@ void SetWaveFreq(bool show) // FOR ANALOGUE & SYNCHRONIZED SQUARE WAVE:
   //  SET FREQUENCY:
   float dutyLimit = 0;
   float allowedWaveDuty = TargetWaveDuty;
+  if (ToneBankMode) StopToneBank(); // hand the DAC back to the analogue wave
+  if (DdsMode && WaveShape != 4) // DDS engine - no FastMode / slow mode
+  {
+    SetDdsWave(show);
+    return;
+  }
   OldFastMode = FastMode; // old FastMode
-  if      (!ExactFreqMode && TargetWaveFreq > 40000) FastMode =  3;
-  else if (!ExactFreqMode && TargetWaveFreq > 20000) FastMode =  2;
-  else if (!ExactFreqMode && TargetWaveFreq > 10000) FastMode =  1;
-  else if (!ExactFreqMode && TargetWaveFreq >  1000) FastMode =  0;
-  else // if slow mode (sample rate of 400kHz)
+  int fastMode = -1;
+  if      (!ExactFreqMode && TargetWaveFreq > 40000) fastMode =  3;
+  else if (!ExactFreqMode && TargetWaveFreq > 20000) fastMode =  2;
+  else if (!ExactFreqMode && TargetWaveFreq > 10000) fastMode =  1;
+  else if (!ExactFreqMode && TargetWaveFreq >  1000) fastMode =  0;
+  if (fastMode >= 0) CreateStaleNewWave(fastMode); // a wave left for later by CreateNewWave() must be ready before DACC_Handler reads it
+  FastMode = fastMode;
+  if (FastMode != OldFastMode) UpdateMultiCycleWave(); // whole cycles of the new FastMode wave (or none in slow mode)
+  if (FastMode < 0) // if slow mode (sample rate of 400kHz)
   {
-    FastMode = -1;
     if (InterruptMode == 0) FreqIncrement = TargetWaveFreq * 21475;
     else FreqIncrement = TargetWaveFreq * 42950;
     double FreqIncr = FreqIncrement;
@@ -3184,12 +4131,18 @@ void SetWaveFreq(bool show) // FOR ANALOGUE & SYNCHRONIZED SQUARE WAVE:
     Serial.print("   Analogue Wave Duty-cycle: "); Serial.print(ActualWaveDuty); Serial.println(" %\n");
   }
   LastAllowedWaveDuty = allowedWaveDuty;
+  SelectTc0Handler(); // MinOrMaxWaveDuty may have changed
 }
 
 void CalculateWaveDuty(bool updateSlowMode) // FOR ANALOGUE & SYNCHRONIZED SQUARE WAVE:
 {
   float dutyLimit = 0;
   float allowedWaveDuty = TargetWaveDuty;
+  if (DdsBlockMode) // DDS engine sets duty-cycle with freq
+  {
+    SetDdsWave(0);
+    return;
+  }
   if (FastMode >= 0)
   {
     //  SET DUTY:
@@ -3269,6 +4222,7 @@ void CalculateWaveDuty(bool updateSlowMode) // FOR ANALOGUE & SYNCHRONIZED SQUAR
     else if (TargetWaveDuty == 100) ActualWaveDuty = ((1000 / ActualWaveFreq) - 0.000048) / (10 / ActualWaveFreq);
     else ActualWaveDuty = constrain(TargetWaveDuty, dutyLimit, 100 - dutyLimit);
   }
+  SelectTc0Handler(); // MinOrMaxWaveDuty or ExactFreqDutyNot50 may have changed
 }
 
 void SetFreqAndDuty(bool setFreq, bool setDuty) // Sets freq & duty-cycle and calculates measurements - FOR UNSYNCHRONIZED SQUARE WAVE:
@@ -3451,8 +4405,160 @@ void TC1_Handler() // used for Unsynchronized Square Wave when below 163Hz (200,
   }
 }
 
+static inline void SyncedSquareEdge(uint32_t effect) // synchronized square wave edge on pin 3, SyncDelay after now - made by TC2 channel 1's RA (& RC) compare, so DACC_Handler returns without waiting
+{
+  TcChannel *t = &(TC2->TC_CHANNEL)[1];
+  uint32_t ra = SyncDelay * SYNC_DELAY_TICKS + 1; // (RA = 0 would never match after a software trigger)
+  t->TC_RA  = ra;
+  t->TC_RC  = ra + SYNC_PULSE_TICKS; // counter stops here
+  t->TC_CMR = TC_CMR_TCCLKS_TIMER_CLOCK1 | TC_CMR_WAVE | TC_CMR_WAVSEL_UP | TC_CMR_CPCSTOP | effect;
+  t->TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG; // the counter is reset and the clock is started
+}
+
+static inline bool GateFlat(uint16_t len) // true if the next len samples are played untouched (gate off, or open for all of them) - counts them off the hold time
+{
+  if (GateState == GATE_OFF) return true;
+  if (GateState != GATE_OPEN || GateHold < len) return false;
+  if (GateHold != GATE_HOLD_ON) GateHold -= len;
+  return true;
+}
+
+static void GateBlock(uint16_t *block, uint16_t len, byte channels) // apply the gate (rise or fall shape from gateshapes.h) to len samples (of each channel - interleaved, as tagged by 2 channel mode) - estimated 15 cycles per sample during a rise or fall
+{
+  if (GateFlat(len)) return;
+  byte     state = GateState;
+  uint32_t pos   = GatePos;
+  uint32_t inc   = GateInc;
+  uint32_t hold  = GateHold;
+  const uint16_t *rise = GateRiseShape;
+  const uint16_t *fall = GateFallShape;
+  for (uint16_t i = 0; i < len; i++, block += channels)
+  {
+    int32_t g; // gain, Q15
+    if (state == GATE_OPEN)
+    {
+      if (hold == 0) state = GATE_FALL;
+      else
+      {
+        if (hold != GATE_HOLD_ON) hold--;
+        continue; // full level
+      }
+    }
+    if (state == GATE_CLOSED) g = 0;
+    else
+    {
+      const uint16_t *t = (state == GATE_RISE) ? rise : fall;
+      uint32_t j = pos >> 22; // (4194304 = 4294967296 / GATE_POINTS)
+      g = t[j] + (((t[j + 1] - t[j]) * (int32_t) ((pos >> 6) & 0xFFFF)) >> 16);
+      if (state == GATE_RISE)
+      {
+        pos += inc;
+        if (pos < inc) // rolled over - at full level from the next sample
+        {
+          state = GATE_OPEN;
+          pos = 0xFFFFFFFF;
+        }
+      }
+      else if (pos < inc) // end of fall - silent from the next sample
+      {
+        state = GATE_CLOSED;
+        pos = 0;
+      }
+      else pos -= inc;
+    }
+    for (byte c = 0; c < channels; c++)
+    {
+      int32_t v = (block[c] & 0x0FFF) - HALFRESOL;
+      block[c] = (block[c] & 0x3000) | (HALFRESOL + ((v * g + 16384) >> 15)); // keeps the channel tag
+    }
+  }
+  GateState = state;
+  GatePos   = pos;
+  GateHold  = hold;
+}
+
 void DACC_Handler(void) // write analogue & synchronized square wave to DAC with DMA - Fast Mode
 {
+  if (NoiseBlockMode) // if streaming noise - the block that has just finished becomes the next DMA buffer once refilled
+  {
+    uint32_t startCycles = DWT->CYCCNT;
+    DACC->DACC_TNPR = (uint32_t) NoiseBlock[NoiseBlockHalf]; // it won't be read again until the block now playing has finished
+    DACC->DACC_TNCR = NOISEBLOCK;
+    DacQueued += NOISEBLOCK;
+    if (NoiseFillDue) NoiseFillsLate++; // the last block hasn't been refilled yet
+    NoiseFillDue = HIGH;
+    NoiseFillHalf = NoiseBlockHalf; // the refill is handed over - the half is toggled here, so a late refill can't make the block now playing be queued again
+    NoiseBlockHalf = !NoiseBlockHalf;
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk; // BlockFillHandler() refills the block at the lowest priority, so the timer & serial interrupts aren't held up while it does
+    IsrCount++;
+    IsrCycles += DWT->CYCCNT - startCycles;
+    return;
+  }
+  if (DdsBlockMode) // if streaming DDS blocks - as noise blocks above
+  {
+    uint32_t startCycles = DWT->CYCCNT;
+    DACC->DACC_TNPR = (uint32_t) DdsBlock[DdsBlockHalf];
+    DACC->DACC_TNCR = DDSBLOCK;
+    DacQueued += DDSBLOCK;
+    if (DdsFillDue) DdsFillsLate++;
+    DdsFillDue = HIGH;
+    DdsFillHalf = DdsBlockHalf;
+    DdsBlockHalf = !DdsBlockHalf;
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    IsrCount++;
+    IsrCycles += DWT->CYCCNT - startCycles;
+    return;
+  }
+  if (ToneBankMode) // if playing the tone bank - queue the selected tone buffer (whole cycles, so it follows the one now playing without a glitch)
+  {
+    byte select = ToneSelect;
+    const uint16_t *first  = ToneBank[ToneSet][ToneQueued]; // buffer samples before the onset / offset
+    const uint16_t *second = first;                          // buffer samples from it on
+    uint16_t edge = 0;                                       // sample the tone starts or stops at - 0 = the whole buffer
+    if (select != ToneQueued && ToneQueued) // stop the tone at OnsetPhase: its 1st samples, then silence
+    {
+      edge = ToneOnsetOffset[ToneQueued - 1];
+      second = ToneBank[ToneSet][0];
+      if (!edge) first = second;
+      ToneQueued = 0;
+    }
+    if (select != ToneQueued && !edge) // start the tone at OnsetPhase (silence before it) - a new tone after a stop at 0 degrees starts in the same buffer
+    {
+      edge = ToneOnsetOffset[select - 1];
+      second = ToneBank[ToneSet][select];
+      if (!edge) first = second;
+      ToneQueued = select;
+      OnsetSample = DacQueued + edge;
+      OnsetReady = HIGH;
+    }
+    const uint16_t *tone = second;
+    bool flat = GateFlat(TONEBLOCK);
+    if (edge || !flat) // the 2 parts of the buffer, or the gate during a rise or fall (or closed) - copied into a buffer of its own
+    {
+      uint16_t *block = ToneGated[ToneGatedHalf];
+      memcpy(block, first, edge * sizeof(uint16_t));
+      memcpy(block + edge, second + edge, (TONEBLOCK - edge) * sizeof(uint16_t));
+      if (!flat) GateBlock(block, TONEBLOCK, 1);
+      tone = block;
+      ToneGatedHalf = !ToneGatedHalf; // as noise blocks: the other one is playing, this one was queued 2 buffers ago & has finished
+    }
+    DACC->DACC_TNPR = (uint32_t) tone;
+    DACC->DACC_TNCR = TONEBLOCK;
+    DacQueued += TONEBLOCK;
+    if (ToneOldSet) ToneOldSet--; // the other set is free once both DMA buffers come from this one
+    IsrCount++;
+    return;
+  }
+  uint32_t startCycles = DWT->CYCCNT;
+  if (MultiOldSet) MultiOldSet--; // the other MultiWave set is free once both DMA buffers come from this one
+  IsrCount++;
+  if (MultiCycleMode && (WaveHalf || MinOrMaxWaveDuty)) // if playing whole cycles - only queued after a 2nd wave half (WaveHalf HIGH = 2nd half now playing), so the cycle isn't broken
+  {
+    DACC->DACC_TNPR = (uint32_t) MultiWave[MultiSet];
+    DACC->DACC_TNCR = MultiLength[MultiSet];
+    IsrCycles += DWT->CYCCNT - startCycles;
+    return;
+  }
   if      (FastMode == 3) DACC->DACC_TNPR = (uint32_t) Wave3[!WaveHalf]; // if (FastMode == 3) // next DMA buffer
   else if (FastMode == 2) DACC->DACC_TNPR = (uint32_t) Wave2[!WaveHalf]; // if (FastMode == 2) // next DMA buffer
   else if (FastMode == 1) DACC->DACC_TNPR = (uint32_t) Wave1[!WaveHalf]; // if (FastMode == 1) // next DMA buffer
@@ -3462,237 +4568,299 @@ void DACC_Handler(void) // write analogue & synchronized square wave to DAC with
   {
     if (SquareWaveSync) // creates squarewave synchronized with triangle or sine wave
     {
-      for (int i = 0; i < SyncDelay; i++) {
-        while (WaveHalf != WaveHalf); // delays of very short duration. ie: less than 1 microsecond amounts, to sync with analogue wave
-      }
-      if (WaveHalf)
-      {
-        TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR; // set TIOA (sq. wave on pin 3) LOW when triggered (on next line)
-        TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG; // software trigger also resets the counter and restarts the clock
-        TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET; // set TIOA (sq. wave on pin 3) HIGH again when triggered (after else statement)
-      }
-      else
-      {
-        TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET;
-        TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG; // the counter is reset and the clock is started
-        TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR;
-      }
-      TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // output is reset (creating 48nS pulse), the counter is reset and the clock is started
+      if (WaveHalf) SyncedSquareEdge(TC_CMR_ACPA_CLEAR | TC_CMR_ACPC_SET); // if duty set to 100 - TIOA (sq. wave on pin 3) LOW at RA, HIGH again at RC (creating 48nS pulse)
+      else          SyncedSquareEdge(TC_CMR_ACPA_SET | TC_CMR_ACPC_CLEAR); // if duty set to 0 - HIGH at RA, LOW again at RC
     }
   }
   else // if duty not set to 0 or 100
   {
     if (SquareWaveSync) // creates squarewave synchronized with triangle or sine wave
     {
-      for (int i = 0; i < SyncDelay; i++) {
-        while (WaveHalf != WaveHalf); // delays of very short duration. ie: less than 1 microsecond amounts, to sync with analogue wave
-      }
-      if (WaveHalf) TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR;
-      else TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET;
-      TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG; // the counter is reset and the clock is started
+      if (WaveHalf) SyncedSquareEdge(TC_CMR_ACPA_CLEAR); // TIOA (sq. wave on pin 3) LOW at RA
+      else          SyncedSquareEdge(TC_CMR_ACPA_SET);   // HIGH at RA
     }
     WaveHalf = !WaveHalf; // change to other wave half
   }
+  IsrCycles += DWT->CYCCNT - startCycles;
+}
+
+// TC0_Handler: write analogue & synchronized square wave to DAC & pin 3 - Slow Mode (400,000 clocks per Sec) - (200,000 clocks per Sec if InterruptMode is 1 or 2 - TC_setup2a,b & c) - (20,000 - 28,000 clocks per Sec as set by NoteDivisor if InterruptMode is 3 - TC_setup2c)
+// One variant per combination of InterruptMode, exact freq mode, 0 or 100% duty & SquareWaveSync, so the only tests left per sample are for the end of the wave half & which half.
+// SelectTc0Handler() writes the variant for the current mode straight into the TC0 vector of RamVectors - there's no TC0_Handler() in flash, or any other call between
+template <byte mode> static inline uint32_t Tc0Sample(const int16_t *table, uint32_t bit) // DAC value for this InterruptMode (1048576 = 4294967296 / 4096)
+{
+  if (mode == 10) return constrain((int16_t) (table[bit >> 20] * WaveAmp >> 16), 0, WAVERESOL-1); // constrained only during calculating of WaveShape 3, composite wave, if mirror effect is OFF as constraining earlier causes clipping and incorrect mixing of high amplitude waves
+  if (mode == 1)  return constrain(((table[bit >> 20] * Modulation) / WAVERESOL) + HALFRESOL, 0, WAVERESOL-1); // Modulate with Analogue 2 input - constrained
+  return (int16_t) (table[bit >> 20] * WaveAmp >> 16);
 }
 
-void TC0_Handler() // write analogue & synchronized square wave to DAC & pin 3 - Slow Mode (400,000 clocks per Sec) - (200,000 clocks per Sec if InterruptMode is 1 or 2 - TC_setup2a,b & c) - (20,000 - 28,000 clocks per Sec as set by NoteDivisor if InterruptMode is 3 - TC_setup2c)
+template <byte mode, byte exact, bool minOrMax, bool sync> void Tc0Handler() // exact: 0 = off, 1 = on at 50% duty-cycle, 2 = on & not at 50% (ExactFreqDutyNot50)
 {
-  TC_GetStatus(TC0, 0);
-  WaveBit += Increment[!WaveHalf]; // add appropriate Increment to WaveBit
-  if (InterruptMode == 0)
+  TC0->TC_CHANNEL[0].TC_SR; // read int status reg to clear pending - as TC_GetStatus(TC0, 0), without the function call
+  bool half = WaveHalf;
+  uint32_t inc = Increment[!half];
+  uint32_t bit = WaveBit + inc; // add appropriate Increment to WaveBit
+  if (mode != 0 && mode != 10 && mode != 1) // Music modes don't write the DAC here
+  {
+    WaveBit = bit;
+    return;
+  }
+  if (bit >= inc) // if not end of wave half
   {
-    if (WaveBit < Increment[!WaveHalf]) // if rolled over. If end of wave half (if 4294967295 exceeded - highest number for 32 bit int before roll-over to zero)
+    WaveBit = bit;
+    DACC->DACC_CDR = Tc0Sample<mode>(half ? WaveFull : WaveFull2, bit); // !WaveHalf = 2nd wave half
+    return;
+  }
+  // if rolled over. If end of wave half (if 4294967295 exceeded - highest number for 32 bit int before roll-over to zero)
+  if (exact == 2) bit = (bit / 1000) * DutyMultiplier[half]; // if not 50% duty-cycle TRY to maintain freq
+  else if (exact == 0) bit = 1; // if not in exact freq mode reset to 1, allowing next update to be lower at 0 (necessary for very low duty cycle)
+  WaveBit = bit;
+  if (minOrMax) // if duty set to 0 or 100 - the same wave half again
+  {
+    DACC->DACC_CDR = Tc0Sample<mode>(half ? WaveFull : WaveFull2, bit);
+    if (sync)
     {
-      if (ExactFreqDutyNot50) // if in exact freq mode and not at 50% duty-cycle
-        WaveBit = (WaveBit / 1000) * DutyMultiplier[WaveHalf]; // if not 50% duty-cycle TRY to maintain freq
-      else if (!ExactFreqMode) WaveBit = 1; // if not in exact freq mode reset to 1, allowing next update to be lower at 0 (necessary for very low duty cycle)
-      if (MinOrMaxWaveDuty) // if duty set to 0 or 100
+      if (half) // if duty set to 100
       {
-        if (!WaveHalf) DACC->DACC_CDR = (int16_t) (WaveFull2[WaveBit >> 20] * WaveAmp >> 16); // if displaying 2nd wave half only (just passed end), write to DAC (1048576 = 4294967296 / 4096)
-        else           DACC->DACC_CDR = (int16_t) (WaveFull[WaveBit >> 20] * WaveAmp >> 16); // if displaying 1st wave half only (just passed end), write to DAC
-        if (SquareWaveSync)
-        {
-          if (WaveHalf) // if duty set to 100
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR; // set TIOA (sq. wave on pin 3) LOW when triggered (on next line)
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // software trigger also resets the counter and restarts the clock
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET; // set TIOA (sq. wave on pin 3) HIGH when triggered (after else statement)
-          }
-          else // if duty set to 0
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET;
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // the counter is reset and the clock is started
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR;
-          }
-          TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // output is reset (creating 48nS pulse), the counter is reset and the clock is started
-        }
-  
+        TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR; // set TIOA (sq. wave on pin 3) LOW when triggered (on next line)
+        TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // software trigger also resets the counter and restarts the clock
+        TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET; // set TIOA (sq. wave on pin 3) HIGH when triggered (after else statement)
       }
-      else // if duty not set to 0 or 100
+      else // if duty set to 0
       {
-        if (WaveHalf)
-        {
-          DACC->DACC_CDR = (int16_t) (WaveFull2[WaveBit >> 20] * WaveAmp >> 16); // if 2nd wave half (just passed end of 1st half), write to DAC (1048576 = 4294967296 / 4096)
-          if (SquareWaveSync)
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR; // set TIOA (sq. wave on pin 3) LOW when triggered (on next line)
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // the counter is reset and the clock is started
-          }
-        }
-        else
-        {
-          DACC->DACC_CDR = (int16_t) (WaveFull[WaveBit >> 20] * WaveAmp >> 16); // if 1st wave half (just passed end of 2nd half), write to DAC (1048576 = 4294967296 / 4096)
-          if (SquareWaveSync)
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET; // set TIOA (sq. wave on pin 3) HIGH when triggered (on next line)
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // the counter is reset and the clock is started
-          }
-        }
-        WaveHalf = !WaveHalf; // change to other wave half
+        TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET;
+        TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // the counter is reset and the clock is started
+        TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR;
       }
+      TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // output is reset (creating 48nS pulse), the counter is reset and the clock is started
     }
-    else // if not end of wave half
+  }
+  else // if duty not set to 0 or 100 - change to other wave half
+  {
+    DACC->DACC_CDR = Tc0Sample<mode>(half ? WaveFull2 : WaveFull, bit);
+    if (sync)
     {
-      if (!WaveHalf) DACC->DACC_CDR = (int16_t) (WaveFull2[WaveBit >> 20] * WaveAmp >> 16); // if 2nd wave half, write to DAC (1048576 = 4294967296 / 4096)
-      else           DACC->DACC_CDR = (int16_t) (WaveFull[WaveBit >> 20] * WaveAmp >> 16); // if 1st wave half, write to DAC (1048576 = 4294967296 / 4096)
+      TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | (half ? TC_CMR_ASWTRG_CLEAR : TC_CMR_ASWTRG_SET); // set TIOA (sq. wave on pin 3) LOW at end of 1st half, HIGH at end of 2nd half, when triggered (on next line)
+      TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // the counter is reset and the clock is started
     }
+    WaveHalf = !half;
+  }
+}
+
+typedef void (*Tc0Variant)();
+Tc0Variant Tc0Timed; // the variant Tc0TimedHandler() times, while PrintCpuLoad() measures slow mode
+
+void Tc0TimedHandler() // run the current TC0_Handler variant & count its cycles - only installed while PrintCpuLoad() measures, as the call adds a few cycles of its own
+{
+  uint32_t startCycles = DWT->CYCCNT;
+  Tc0Timed();
+  IsrCount++;
+  IsrCycles += DWT->CYCCNT - startCycles;
+}
+
+template <byte mode, byte exact, bool minOrMax> static Tc0Variant Tc0PickSync(bool sync) { return sync ? Tc0Handler<mode, exact, minOrMax, 1> : Tc0Handler<mode, exact, minOrMax, 0>; }
+template <byte mode, byte exact> static Tc0Variant Tc0PickDuty(bool minOrMax, bool sync) { return minOrMax ? Tc0PickSync<mode, exact, 1>(sync) : Tc0PickSync<mode, exact, 0>(sync); }
+template <byte mode> static Tc0Variant Tc0PickExact(byte exact, bool minOrMax, bool sync)
+{
+  if (exact == 2) return Tc0PickDuty<mode, 2>(minOrMax, sync);
+  if (exact == 1) return Tc0PickDuty<mode, 1>(minOrMax, sync);
+  return Tc0PickDuty<mode, 0>(minOrMax, sync);
+}
+
+void SelectTc0Handler(bool timed) // install the TC0_Handler variant for the current mode - call after changing InterruptMode, ExactFreqMode, ExactFreqDutyNot50, MinOrMaxWaveDuty or SquareWaveSync. timed: via Tc0TimedHandler(), to measure it
+{
+  byte exact = ExactFreqDutyNot50 ? 2 : ExactFreqMode;
+  Tc0Variant handler;
+  if      (InterruptMode ==  0) handler = Tc0PickExact< 0>(exact, MinOrMaxWaveDuty, SquareWaveSync);
+  else if (InterruptMode == 10) handler = Tc0PickExact<10>(exact, MinOrMaxWaveDuty, SquareWaveSync);
+  else if (InterruptMode ==  1) handler = Tc0PickExact< 1>(exact, MinOrMaxWaveDuty, SquareWaveSync);
+  else handler = Tc0Handler<2, 0, 0, 0>;
+  Tc0Timed = handler;
+  if (timed) handler = Tc0TimedHandler;
+  RamVectors[TC0_IRQn + 16] = handler; // a single word write - the next interrupt uses either the old or the new variant
+  __DSB();
+}
+
+void RamVectorSetup() // copy the vector table from flash to RAM, so SelectTc0Handler() can change the TC0 vector - & install BlockFillHandler() as PendSV
+{
+  void (**flashVectors)() = (void (**)()) SCB->VTOR;
+  for (uint16_t i = 0; i < VECTORS; i++) RamVectors[i] = flashVectors[i];
+  SelectTc0Handler(); // there's no TC0_Handler() in flash
+  RamVectors[PendSV_IRQn + 16] = BlockFillHandler;
+  NVIC_SetPriority(PendSV_IRQn, (1 << __NVIC_PRIO_BITS) - 1); // lowest priority - below every peripheral interrupt
+  noInterrupts();
+  SCB->VTOR = (uint32_t) RamVectors; // SRAM address, so TBLBASE (bit 29) is set
+  __DSB();
+  interrupts();
+}
+
+static inline int16_t WhiteSample() // 16 bit white noise sample - uses both halves of each 32 bit TRNG word
+{
+  if (TrngHalf) // upper half of last word not used yet
+  {
+    TrngHalf = LOW;
+    return TrngWord >> 16;
+  }
+  if (TRNG->TRNG_ISR & TRNG_ISR_DATRDY) // if new TRNG word ready (reading ISR clears DATRDY)
+  {
+    TrngWord = TRNG->TRNG_ODATA;
+    XorState ^= TrngWord; // keep re-seeding the fallback generator
+    if (XorState == 0) XorState = 1;
+  }
+  else // read too early - the TRNG would return the last word again, so use xorshift32 instead
+  {
+    TrngEarlyReads++;
+    XorState ^= XorState << 13;
+    XorState ^= XorState >> 17;
+    XorState ^= XorState << 5;
+    TrngWord = XorState;
+  }
+  TrngHalf = HIGH;
+  return TrngWord;
+}
+
+struct TrngWhiteSource // white noise sources for NoiseRender()
+{
+  int16_t operator()() { return WhiteSample(); }
+};
+TrngWhiteSource TrngWhite;
+NoiseRngSource  FrozenWhite = {&FrozenRng};
+
+static inline uint16_t NoiseSample() // create 1 coloured noise sample for the DAC - used by TC2_Handler
+{
+  int32_t gain = NoiseGain(NoiseAmp);
+  if (!gain) return HALFRESOL; // silent - no dither either
+  #ifdef NOISEBANK
+  if (NoiseSource == 2) // read from noise bank
+  {
+    int32_t v = (NoiseBank[NoiseBankPos] - HALFRESOL) << 12;
+    if (++NoiseBankPos == NOISEBANK_SAMPLES) NoiseBankPos = 0;
+    return NoiseDacOutput(v, gain, &Noise.dither);
+  }
+  #endif
+  if (NoiseSource == 1) return NoiseOutput(&Noise, FrozenWhite, gain); // see noisedsp.h
+  return NoiseOutput(&Noise, TrngWhite, gain);
+}
+
+void TC2_Handler() // write TRNG noise to analogue DAC pin - clocked at 42 MHz / NOISE_DIVISOR - only used when NoiseDMA is off
+{
+  uint32_t startCycles = DWT->CYCCNT;
+  TC_GetStatus(TC0, 2);
+  DACC->DACC_CDR = NoiseSample();
+  IsrCount++;
+  IsrCycles += DWT->CYCCNT - startCycles;
+}
+
+template <class White>
+static inline void RenderNoiseBlock(uint16_t *block, uint16_t len, White &white, int32_t gain) // one loop per white noise source, so the source isn't tested on every sample
+{
+  for (uint16_t i = 0; i < len; i++) block[i] = NoiseOutput(&Noise, white, gain);
+}
+
+static void FillNoiseSamples(uint16_t *block, uint16_t len) // TRNG, frozen or noise bank samples
+{
+  int32_t gain = NoiseGain(NoiseAmp); // read once per block
+  if (!gain) // silent - no dither either
+  {
+    for (uint16_t i = 0; i < len; i++) block[i] = HALFRESOL;
+    return;
   }
-  else if (InterruptMode == 10) // constrained only during calculating of WaveShape 3, composite wave, if mirror effect is OFF as constraining earlier causes clipping and incorrect mixing of high amplitude waves. This makes the wave look good during calculating, although it slows the calculating process a little.
+  #ifdef NOISEBANK
+  if (NoiseSource == 2) // copy from noise bank in flash, with gain & dither - estimated 15 cycles per sample
   {
-    if (WaveBit < Increment[!WaveHalf]) // if rolled over. If end of wave half (if 4294967295 exceeded - highest number for 32 bit int before roll-over to zero)
+    uint32_t pos = NoiseBankPos;
+    for (uint16_t i = 0; i < len; i++)
     {
-      if (ExactFreqDutyNot50) // if in exact freq mode and not at 50% duty-cycle
-        WaveBit = (WaveBit / 1000) * DutyMultiplier[WaveHalf]; // if not 50% duty-cycle TRY to maintain freq
-      else if (!ExactFreqMode) WaveBit = 1; // if not in exact freq mode reset to 1, allowing next update to be lower at 0 (necessary for very low duty cycle)
-      if (MinOrMaxWaveDuty) // if duty set to 0 or 100
-      {
-        if (!WaveHalf) DACC->DACC_CDR = constrain((int16_t) (WaveFull2[WaveBit >> 20] * WaveAmp >> 16), 0, WAVERESOL-1); // if displaying 2nd wave half only (just passed end), write to DAC (1048576 = 4294967296 / 4096)
-        else           DACC->DACC_CDR = constrain((int16_t) (WaveFull[WaveBit >> 20] * WaveAmp >> 16), 0, WAVERESOL-1); // if displaying 1st wave half only (just passed end), write to DAC
-        if (SquareWaveSync)
-        {
-          if (WaveHalf) // if duty set to 100
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR; // set TIOA (sq. wave on pin 3) LOW when triggered (on next line)
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // software trigger also resets the counter and restarts the clock
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET; // set TIOA (sq. wave on pin 3) HIGH when triggered (after else statement)
-          }
-          else // if duty set to 0
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET;
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // the counter is reset and the clock is started
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR;
-          }
-          TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // output is reset (creating 48nS pulse), the counter is reset and the clock is started
-        }
-      }
-      else // if duty not set to 0 or 100
-      {
-        if (WaveHalf)
-        {
-          DACC->DACC_CDR = constrain((int16_t) (WaveFull2[WaveBit >> 20] * WaveAmp >> 16), 0, WAVERESOL-1); // if 2nd wave half (just passed end of 1st half), write to DAC (1048576 = 4294967296 / 4096)
-          if (SquareWaveSync)
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR; // set TIOA (sq. wave on pin 3) LOW when triggered (on next line)
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // the counter is reset and the clock is started
-          }
-        }
-        else
-        {
-          DACC->DACC_CDR = constrain((int16_t) (WaveFull[WaveBit >> 20] * WaveAmp >> 16), 0, WAVERESOL-1); // if 1st wave half (just passed end of 2nd half), write to DAC (1048576 = 4294967296 / 4096)
-          if (SquareWaveSync)
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET; // set TIOA (sq. wave on pin 3) HIGH when triggered (on next line)
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // the counter is reset and the clock is started
-          }
-        }
-        WaveHalf = !WaveHalf; // change to other wave half
-      }
+      block[i] = NoiseDacOutput((NoiseBank[pos] - HALFRESOL) << 12, gain, &Noise.dither);
+      if (++pos == NOISEBANK_SAMPLES) pos = 0;
     }
-    else // if not end of wave half
+    NoiseBankPos = pos;
+    return;
+  }
+  #endif
+  if (UserFir.taps) // uploaded FIR filter (nf)
+  {
+    if (NoiseSource == 1) NoiseFirRender(&Noise, &UserFir, FrozenWhite, block, len, gain);
+    else NoiseFirRender(&Noise, &UserFir, TrngWhite, block, len, gain);
+  }
+  else if (NoiseSource == 1) RenderNoiseBlock(block, len, FrozenWhite, gain);
+  else RenderNoiseBlock(block, len, TrngWhite, gain);
+}
+
+void BlockFillHandler() // PendSV (lowest priority) - refill the noise or DDS block DACC_Handler has just queued, while the other block is playing. Any other interrupt can run during the fill (nl & I measure how long it takes)
+{
+  uint32_t startCycles = DWT->CYCCNT;
+  if (NoiseFillDue)
+  {
+    byte half = NoiseFillHalf;
+    if (NoiseBlockMode) FillNoiseBlock(NoiseBlock[half], NOISEBLOCK);
+    noInterrupts();
+    if (NoiseFillHalf == half) NoiseFillDue = LOW; // if DACC_Handler queued another block meanwhile, it's still due - PendSV is pending again to refill it
+    interrupts();
+  }
+  if (DdsFillDue) // as noise above
+  {
+    byte half = DdsFillHalf;
+    if (DdsBlockMode) FillDdsBlock(DdsBlock[half], DDSBLOCK);
+    noInterrupts();
+    if (DdsFillHalf == half) DdsFillDue = LOW;
+    interrupts();
+  }
+  IsrCount++;
+  IsrCycles += DWT->CYCCNT - startCycles; // includes any interrupts that ran during it
+}
+
+void FillNoiseBlock(uint16_t *block, uint16_t len) // fill a DMA block with TRNG noise - called from BlockFillHandler() while the other block is playing
+{
+  FillNoiseSamples(block, len);
+  GateBlock(block, len, 1);
+}
+
+template <bool interpolate> static void FillDds(DdsChannel &dds, uint16_t *block, uint16_t len, byte step, uint16_t tag) // DDS samples for 1 DAC, every step'th halfword of block - interpolate: read between wave table points (1 multiply more per sample)
+{
+  uint32_t phase = dds.Phase;
+  byte     half  = dds.Half;
+  const int16_t *table = half ? WaveFull2 : WaveFull;
+  uint32_t inc = dds.Increment[half];
+  uint32_t amp = WaveAmp;
+  for (uint16_t i = 0; i < len; i++, block += step)
+  {
+    int32_t v = table[phase >> 20]; // (1048576 = 4294967296 / 4096)
+    if (interpolate) v += ((table[(phase >> 20) + 1] - v) * (int32_t) ((phase >> 8) & 0xFFF) + 2048) >> 12; // rounded - truncating adds a 2nd harmonic. WaveFull[NWAVEFULL] & WaveFull2[NWAVEFULL] hold the start of the other half
+    uint32_t out = v * amp >> 16;
+    *block = (out > 4095 ? 4095 : out) | tag; // clamped to 12 bits, so a sample can't spill into the channel tag (bits 12 & 13)
+    phase += inc;
+    if (phase < inc && !DdsOneHalf) // if rolled over (end of wave half) - the phase left over is carried into the other half at its rate, so freq is exact at any duty-cycle
     {
-      if (!WaveHalf) DACC->DACC_CDR = constrain((int16_t) (WaveFull2[WaveBit >> 20] * WaveAmp >> 16), 0, WAVERESOL-1); // if 2nd wave half, write to DAC (1048576 = 4294967296 / 4096)
-      else           DACC->DACC_CDR = constrain((int16_t) (WaveFull[WaveBit >> 20] * WaveAmp >> 16), 0, WAVERESOL-1); // if 1st wave half, write to DAC (1048576 = 4294967296 / 4096)
+      half  = !half;
+      table = half ? WaveFull2 : WaveFull;
+      inc   = dds.Increment[half];
+      uint64_t carried = (uint64_t) phase * dds.Ratio[half] >> 16;
+      phase = carried > 0xFFFFFFFF ? 0xFFFFFFFF : carried; // more than the whole of the new half (duty at its 1 sample limit) - it ends on the next sample
     }
   }
-  else  if (InterruptMode == 1) // Modulate with Analogue 2 input - constrained 
+  dds.Phase = phase;
+  dds.Half  = half;
+}
+
+void FillDdsBlock(uint16_t *block, uint16_t len) // next block of the analogue wave from the DDS phase accumulator - as TC0_Handler, but with no interrupt per sample. len is in DMA transfers: 2 samples each in 2 channel mode
+{
+  if (DdsStereo) // DAC0 & DAC1 samples interleaved (DAC0 in the low halfword, converted first), each tagged with its channel in bits 12 & 13
   {
-    if (WaveBit < Increment[!WaveHalf]) // if rolled over. If end of wave half (if 4294967295 exceeded - highest number for 32 bit int before roll-over to zero)
+    if (DdsInterpolate)
     {
-      if (ExactFreqDutyNot50) // if in exact freq mode and not at 50% duty-cycle
-        WaveBit = (WaveBit / 1000) * DutyMultiplier[WaveHalf]; // if not 50% duty-cycle TRY to maintain freq
-      else if (!ExactFreqMode) WaveBit = 1; // if not in exact freq mode reset to 1, allowing next update to be lower at 0 (necessary for very low duty cycle)
-      if (MinOrMaxWaveDuty) // if duty set to 0 or 100
-      {
-        if (!WaveHalf) DACC->DACC_CDR = constrain(((WaveFull2[WaveBit >> 20] * Modulation) / WAVERESOL) + HALFRESOL, 0, WAVERESOL-1); // if displaying 2nd wave half only (just passed end), write to DAC (1048576 = 4294967296 / 4096)
-        else           DACC->DACC_CDR = constrain(((WaveFull[WaveBit >> 20] * Modulation) / WAVERESOL) + HALFRESOL, 0, WAVERESOL-1); // if displaying 1st wave half only (just passed end), write to DAC
-        if (SquareWaveSync)
-        {
-          if (WaveHalf) // if duty set to 100
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR; // set TIOA (sq. wave on pin 3) LOW when triggered (on next line)
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // software trigger also resets the counter and restarts the clock
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET; // set TIOA (sq. wave on pin 3) HIGH when triggered (after else statement)
-          }
-          else // if duty set to 0
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET;
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // the counter is reset and the clock is started
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR;
-          }
-          TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // output is reset (creating 48nS pulse), the counter is reset and the clock is started
-        }
-      }
-      else // if duty not set to 0 or 100
-      {
-        if (WaveHalf)
-        {
-          DACC->DACC_CDR = constrain(((WaveFull2[WaveBit >> 20] * Modulation) / WAVERESOL) + HALFRESOL, 0, WAVERESOL-1); // if 2nd wave half (just passed end of 1st half), write to DAC (1048576 = 4294967296 / 4096)
-          if (SquareWaveSync)
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_CLEAR; // set TIOA (sq. wave on pin 3) LOW when triggered (on next line)
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // the counter is reset and the clock is started
-          }
-        }
-        else
-        {
-          DACC->DACC_CDR = constrain(((WaveFull[WaveBit >> 20] * Modulation) / WAVERESOL) + HALFRESOL, 0, WAVERESOL-1); // if 1st wave half (just passed end of 2nd half), write to DAC (1048576 = 4294967296 / 4096)
-          if (SquareWaveSync)
-          {
-            TC2->TC_CHANNEL[1].TC_CMR = TC_CMR_WAVE | TC_CMR_ASWTRG_SET; // set TIOA (sq. wave on pin 3) HIGH when triggered (on next line)
-            TC2->TC_CHANNEL[1].TC_CCR = TC_CCR_SWTRG; // the counter is reset and the clock is started
-          }
-        }
-        WaveHalf = !WaveHalf; // change to other wave half
-      }
+      FillDds<true>(Dds[0], block, len, 2, 0);
+      FillDds<true>(Dds[1], block + 1, len, 2, 1 << 12);
     }
-    else // if not end of wave half
+    else
     {
-      if (!WaveHalf) DACC->DACC_CDR = constrain(((WaveFull2[WaveBit >> 20] * Modulation) / WAVERESOL) + HALFRESOL, 0, WAVERESOL-1); // if 2nd wave half, write to DAC (1048576 = 4294967296 / 4096)
-      else           DACC->DACC_CDR = constrain(((WaveFull[WaveBit >> 20] * Modulation) / WAVERESOL) + HALFRESOL, 0, WAVERESOL-1); // if 1st wave half, write to DAC (1048576 = 4294967296 / 4096)
+      FillDds<false>(Dds[0], block, len, 2, 0);
+      FillDds<false>(Dds[1], block + 1, len, 2, 1 << 12);
     }
   }
-}
-
-void TC2_Handler() // write TRNG noise to analogue DAC pin - clocked at 150 kHz
-{
-  TC_GetStatus(TC0, 2);
-  int16_t newReading  = trng_read_output_data(TRNG);
-  int16_t nextReading = TrngNum;
-  TrngFast    += ((newReading - TrngFast) * 2 / 10); // fixed high freq filter
-  int16_t fastR = newReading - TrngFast;
-  nextReading += (newReading - TrngNum) * NoiseCol / 10000; // average
-  TrngNum     += (nextReading - TrngNum) * NoiseCol / 10000; // average some more
-  if (TrngCount == 3) // clocked at 50kHz
-  {
-    TrngCount = 0;
-    TrngSlo += (newReading - TrngSlo) * NoiseLFC / 100; // low freq filter - average
-  }
-  else TrngCount++;
-  
-  // reduce from 16 bit to 12 bit and adjust balance and amplitude
-  uint16_t n = constrain(((((TrngNum / 16) * NoiseFil / 100) + ((TrngSlo / 16) * NoiseLFB / 70) + ((fastR / 16) * NoiseHFB / 1000)) * 3) + HALFRESOL, 0, 4095);
-  uint32_t a = n * NoiseAmp >> 16;
-  DACC->DACC_CDR = constrain((uint16_t) (a), 0, 4095);
+  else if (DdsInterpolate) FillDds<true>(Dds[0], block, len, 1, 0);
+  else FillDds<false>(Dds[0], block, len, 1, 0);
+  GateBlock(block, len, DdsStereo ? 2 : 1);
 }
 
 void TC_setup() // system timer clock set-up for analogue wave & synchronized square wave when in fast mode
@@ -3715,13 +4883,36 @@ void TC_setup1() // system timer clock set-up for TRNG Noise
   pmc_enable_periph_clk(ID_TC2);   // enable peripheral clock TC0
   // we want wavesel 01 with RC:
   TC_Configure(/* clock */TC0,/* channel */2, TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC | TC_CMR_TCCLKS_TIMER_CLOCK1); // select 42 MHz clock
-  TC_SetRC(TC0, 2, 280); // select divisor of 280 (42 MHz / 280) - clocks DAC at 150kHz
+  TC_SetRC(TC0, 2, NoiseDivisor); // select divisor of NOISE_DIVISOR - clocks DAC at 150kHz with the default of 280 (noise bank is played at the rate it was rendered)
+  if (NoiseDMA) // TIOA2 triggers the DAC directly (see dac_setup3) - no timer interrupt needed
+  {
+    TC0->TC_CHANNEL[2].TC_RA = NoiseDivisor / 2;
+    TC0->TC_CHANNEL[2].TC_CMR = (TC0->TC_CHANNEL[2].TC_CMR & 0xFFF0FFFF) | TC_CMR_ACPA_CLEAR | TC_CMR_ACPC_SET;
+    TC0->TC_CHANNEL[2].TC_IDR = 0xFFFFFFFF; // IDR = interrupt disable register
+    NVIC_DisableIRQ(TC2_IRQn);
+    TC_Start(TC0, 2);
+    return;
+  }
   TC_Start(TC0, 2);
   TC0->TC_CHANNEL[2].TC_IER = TC_IER_CPCS; // IER = interrupt enable register
   TC0->TC_CHANNEL[2].TC_IDR = ~TC_IER_CPCS; // IDR = interrupt disable register
   NVIC_EnableIRQ(TC2_IRQn);
 }
 
+void TC_setup6(uint16_t divisor) // system timer clock set-up for the tone bank & DDS engine - TIOA0 triggers the DAC at 42 MHz / divisor (see dac_setup4())
+{
+  pmc_enable_periph_clk(TC_INTERFACE_ID);
+  TcChannel * t = &(TC0->TC_CHANNEL)[0];
+  t->TC_CCR = TC_CCR_CLKDIS;
+  t->TC_IDR = 0xFFFFFFFF;
+  t->TC_SR;
+  t->TC_CMR = TC_CMR_TCCLKS_TIMER_CLOCK1 |  TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC;
+  t->TC_RC = divisor;
+  t->TC_RA = divisor / 2;
+  t->TC_CMR = (t->TC_CMR & 0xFFF0FFFF) | TC_CMR_ACPA_CLEAR | TC_CMR_ACPC_SET;
+  t->TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG;
+}
+
 void TC_setup2() // system timer clock set-up for analogue wave & triggering synchronized square wave when in slow mode
 {
   pmc_set_writeprotect(false);     // disable write protection for pmc registers
@@ -3824,27 +5015,7 @@ void TC_setup5() // timer clock set-up for timer - when operated from the serial
 
 void NoiseFilterSetup()
 {
-  NoiseCol = constrain(NoiseColour * 10, 0, 10000); // setup for TC2_Handler: (NoiseColour for white is 1000, pink is 500 & brown is 30)
-  if      (NoiseCol > 7500) NoiseCol = map(NoiseCol, 10000, 7500, 10000, 4500); // Main Low Pass linearity - NoiseCol is 10000 when colour input NoiseCol is full 10000 (white), then deceases to 4500 as colour input reduces to 7500
-  else if (NoiseCol > 5000) NoiseCol = map(NoiseCol, 7500, 5000, 4500, 3500);
-  else                      NoiseCol = map(NoiseCol, 5000, 0, 3500, 0);         // Main Low Pass linearity - NoiseCol is 0 when colour input NoiseCol is 0 (< brown), then inceases to 4000 as colour input increases to 5000
-  if      (NoiseCol > 6000) NoiseLFB = map(NoiseCol, 10000, 6000, 0, 10);      // Lo Freq boost - amplitude NoiseLFB is min 0 when colour input NoiseCol is full 10000 (white), then inceases to 10 as colour input reduces to 6000
-  else if (NoiseCol > 4000) NoiseLFB = map(NoiseCol, 6000, 4000, 10, 150);
-  else if (NoiseCol > 1500) NoiseLFB = map(NoiseCol, 4000, 1500, 150, 250);
-  else if (NoiseCol >  150) NoiseLFB = map(NoiseCol, 1500, 150, 250, 0);       // Lo Freq boost - amplitude NoiseLFB is min 0 when colour input NoiseCol is below 150 (~ brown), then inceases to 250 as colour input increases to 1500
-  else                      NoiseLFB = 0;
-  NoiseLFC  = constrain(map(NoiseCol, 5500, 3800, 15, 2), 2, 15);              // Lo Freq boost - cut-off freq NoiseLFC is max 15 when colour input NoiseCol is full 10000 (white), then decreases to 2 just before colour input reduces to 3800 (just above pink at 3500 - with user input of 500 before multiplying to 5000)
-  if      (NoiseCol > 6000) NoiseHFB = map(NoiseCol, 10000, 6000, 0, 350);     // Hi Freq boost - amplitude NoiseHFB is min 0 when colour input NoiseCol is full 10000 (white), then inceases to 350 as colour input reduces to 6000
-  else if (NoiseCol > 4000) NoiseHFB = map(NoiseCol, 6000, 4000, 350, 250);
-  else if (NoiseCol > 2000) NoiseHFB = map(NoiseCol, 4000, 2000, 250, 80);
-  else if (NoiseCol >  150) NoiseHFB = map(NoiseCol, 4000, 150, 80, 0);        // Hi Freq boost - amplitude NoiseHFB is min 0 when colour input NoiseCol is below 150 (~ brown), then inceases to 80 as colour input increases to 4000
-  else                      NoiseHFB = 0;
-  if      (NoiseCol > 6500) NoiseFil = map(NoiseCol, 10000, 6500, 100, 66);    // Main Low Pass - amplitude NoiseFil is max 100 when colour input NoiseCol is full 10000 (white), then decreases to 66 as colour input reduces to 6500
-  else if (NoiseCol > 4000) NoiseFil = map(NoiseCol, 6500, 4000, 66, 75);
-  else if (NoiseCol > 1500) NoiseFil = map(NoiseCol, 4000, 1500, 75, 120);
-  else if (NoiseCol >  700) NoiseFil = map(NoiseCol, 1500, 700, 120, 500);
-  else if (NoiseCol >  300) NoiseFil = map(NoiseCol, 700, 300, 500, 1500);
-  else                      NoiseFil = map(NoiseCol, 300, 0, 1500, 4000);      // Main Low Pass - amplitude NoiseFil is 4000 when colour input NoiseCol is 0 (sub-brown), then deceases to 1500 as colour input increases to 300
+  Noise.colour = &NoiseColours.colour[min(NoiseColour, 1000)]; // (NoiseColour for white is 1000, pink is 500 & brown is 30) - the running filter picks up the new colour on its next sample
   if (WaveShape == 4)
   {
     Serial.print("   Noise Colour is "); Serial.print(NoiseColour);
@@ -3857,6 +5028,10 @@ void NoiseFilterSetup()
 
 void dac_setup() // DAC set-up for analogue wave & synchronized square wave when in fast mode and using DMA (above 1kHz and Exact Freq Mode off)
 {
+  MultiOldSet = 0; // DMA restarts from Wave0 (below)
+  NoiseBlockMode = LOW;
+  ToneBankMode = LOW;
+  DdsBlockMode = LOW;
   pmc_enable_periph_clk (DACC_INTERFACE_ID);   // start clocking DAC
   dacc_reset(DACC);
   dacc_set_transfer_mode(DACC, 0);
@@ -3880,6 +5055,10 @@ void dac_setup() // DAC set-up for analogue wave & synchronized square wave when
 
 void dac_setup2() // DAC set-up for analogue & synchronized square wave when in slow mode (below 1kHz or Exact Freq Mode on at any freq)
 {
+  MultiOldSet = 0; // no DMA in slow mode
+  NoiseBlockMode = LOW;
+  ToneBankMode = LOW;
+  DdsBlockMode = LOW;
   NVIC_DisableIRQ(DACC_IRQn);
   NVIC_ClearPendingIRQ(DACC_IRQn);
   dacc_disable_interrupt(DACC, DACC_IER_ENDTX); // disable DMA
@@ -3888,4 +5067,66 @@ void dac_setup2() // DAC set-up for analogue & synchronized square wave when in
   dacc_enable_channel(DACC, 0);                 // un-comment these 2 lines to enable DAC0
 //  dacc_set_channel_selection(DACC, 1);          // un-comment these 2 lines to enable DAC1
 //  dacc_enable_channel(DACC, 1);                 // un-comment these 2 lines to enable DAC1
-}
\ No newline at end of file
+}
+
+void dac_setup3() // DAC set-up for noise streamed in blocks with DMA - triggered by TIOA2 (TC0 channel 2 - see TC_setup1())
+{
+  NVIC_DisableIRQ(DACC_IRQn);
+  NVIC_ClearPendingIRQ(DACC_IRQn);
+  pmc_enable_periph_clk(DACC_INTERFACE_ID);
+  dacc_reset(DACC);
+  dacc_set_transfer_mode(DACC, 0);
+  dacc_set_power_save(DACC, 0, 1);            // sleep = 0, fast wakeup = 1
+  dacc_set_analog_control(DACC, DACC_ACR_IBCTLCH0(0x02) | DACC_ACR_IBCTLCH1(0x02) | DACC_ACR_IBCTLDACCORE(0x01));
+  dacc_set_trigger(DACC, 3);                  // trigger 3 = TIOA2
+  dacc_set_channel_selection(DACC, 0);        // DAC0 - also see dac_setup() above
+  dacc_enable_channel(DACC, 0);
+  MultiOldSet = 0;                            // no MultiWave in the DMA now
+  ToneBankMode = LOW;
+  DdsBlockMode = LOW;
+  SCB->ICSR = SCB_ICSR_PENDSVCLR_Msk; // no refill left over from the last time noise played
+  NoiseFillDue = LOW;
+  NoiseBlockHalf = 0; // NoiseBlock[0] plays first, so it's the next to be queued again
+  NoiseFillHalf = 0;
+  FillNoiseBlock(NoiseBlock[0], NOISEBLOCK);
+  FillNoiseBlock(NoiseBlock[1], NOISEBLOCK);
+  NoiseBlockMode = HIGH;
+  NVIC_EnableIRQ(DACC_IRQn);
+  dacc_enable_interrupt(DACC, DACC_IER_ENDTX);
+  DACC->DACC_TPR  = (uint32_t) NoiseBlock[0]; // DMA buffer
+  DACC->DACC_TCR  = NOISEBLOCK;
+  DACC->DACC_TNPR = (uint32_t) NoiseBlock[1]; // next DMA buffer
+  DACC->DACC_TNCR = NOISEBLOCK;
+  DacQueued = 2 * NOISEBLOCK;
+  DACC->DACC_PTCR = 0x00000100;
+}
+
+void dac_setup4(uint16_t *first, uint16_t *next, uint16_t len) // DAC set-up for the tone bank or DDS blocks streamed by DMA - triggered by TIOA0 (TC0 channel 0 - see TC_setup6()). Set ToneBankMode or DdsBlockMode first
+{
+  NVIC_DisableIRQ(DACC_IRQn);
+  NVIC_ClearPendingIRQ(DACC_IRQn);
+  pmc_enable_periph_clk(DACC_INTERFACE_ID);
+  dacc_reset(DACC);
+  bool stereo = DdsBlockMode && DdsStereo;
+  dacc_set_transfer_mode(DACC, stereo);       // 2 channel mode: word transfers, 2 samples (DAC0 & DAC1) per DMA transfer
+  dacc_set_power_save(DACC, 0, 1);            // sleep = 0, fast wakeup = 1
+  dacc_set_analog_control(DACC, DACC_ACR_IBCTLCH0(0x02) | DACC_ACR_IBCTLCH1(0x02) | DACC_ACR_IBCTLDACCORE(0x01));
+  dacc_set_trigger(DACC, 1);                  // trigger 1 = TIOA0 - each trigger converts 1 sample
+  dacc_set_channel_selection(DACC, 0);        // DAC0 - also see dac_setup() above
+  dacc_enable_channel(DACC, 0);
+  if (stereo)
+  {
+    dacc_enable_flexible_selection(DACC);     // tag mode: the channel is read from bits 12 & 13 of each sample
+    dacc_enable_channel(DACC, 1);             // DAC1 - disabled again by dacc_reset() in the other set-ups
+  }
+  MultiOldSet = 0;                            // no MultiWave in the DMA now
+  NoiseBlockMode = LOW;
+  NVIC_EnableIRQ(DACC_IRQn);
+  dacc_enable_interrupt(DACC, DACC_IER_ENDTX);
+  DACC->DACC_TPR  = (uint32_t) first;         // DMA buffer
+  DACC->DACC_TCR  = len;
+  DACC->DACC_TNPR = (uint32_t) next;          // next DMA buffer
+  DACC->DACC_TNCR = len;
+  DacQueued = 2 * len;
+  DACC->DACC_PTCR = 0x00000100;
+}
@@ -8,10 +8,14 @@ void Settings(byte, int, boolean);
 void SaveToFlash(int);
 void SaveMusicToFlash(int);
 void CreateWaveFull(byte);
+void SineBenchmark();
 void CreateWaveTable();
 void CreateNewWave();
-void Create1stHalfNewWave(byte, float);
-void Create2ndHalfNewWave(int, float);
+void CreateStaleNewWave(byte);
+void CreateFastModeWave(byte);
+void UpdateMultiCycleWave();
+void Create1stHalfNewWave(byte);
+void Create2ndHalfNewWave(byte);
 void Loop_DAWG();
 void MusicEnterExit(byte);
 void SetFreqPeriod();
@@ -28,6 +32,38 @@ void EnterTimerMode();
 void timerRun();
 void ExitTimerMode();
 void ChangeWaveShape(bool);
+void StartNoise();
+void StopNoise();
+void SetNoiseSeed(uint32_t);
+void SetNoiseBand(uint16_t);
+void PrintNoiseSource();
+void LoadNoiseFir(uint16_t);
+void LoadNoiseIir(byte);
+void PrintFirBudget();
+void ToneBankSetup();
+void SetToneAmp(uint32_t);
+void StartToneBank();
+void SelectTone(uint16_t);
+void StopToneBank();
+void SetOnsetPhase(float);
+uint32_t DacSampleNow();
+bool ToneOnset(uint32_t *);
+uint32_t BlockSampleRate();
+const uint16_t *GateShapeRise(byte);
+void SetGate(float, byte, byte);
+bool StartGate(uint32_t);
+void GateRelease();
+void CloseGate();
+bool GateClosed();
+bool ToneSilent();
+void SetDdsWave(bool);
+void StartDds();
+void StopDds();
+void ToggleDdsMode();
+void RestartDds();
+void ToggleDdsStereo();
+void SetDdsOffset(double);
+void PrintCpuLoad();
 void ToggleExactFreqMode();
 void ToggleSquareWaveSync(bool);
 void EnterSweepMode();
@@ -46,11 +82,15 @@ void SetFreqAndDuty(bool, bool);
 void SetPWM(byte, uint32_t, uint32_t);
 void TC1_Handler();
 void DACC_Handler();
-void TC0_Handler();
+void SelectTc0Handler(bool = 0);
+void RamVectorSetup();
 void RunInterrupt3();
 void TC4_Handler();
 void TC5_Handler();
 void TC2_Handler();
+void BlockFillHandler();
+void FillNoiseBlock(uint16_t *, uint16_t);
+void FillDdsBlock(uint16_t *, uint16_t);
 void TC_setup();
 void TC_setup1();
 void TC_setup2();
@@ -60,14 +100,16 @@ void TC_setup2c();
 void TC_setup3();
 void TC_setup4();
 void TC_setup5();
-void TC_setup6();
+void TC_setup6(uint16_t);
 void TC_setup8();
 void NoiseFilterSetup();
 void dac_setup();
 void dac_setup2();
+void dac_setup3();
+void dac_setup4(uint16_t *, uint16_t *, uint16_t);
 void updatePots(uint8_t);
 
-extern uint16_t NoiseAmp;
+extern uint32_t NoiseAmp;
 extern float    SinAmp;
 extern uint32_t WaveAmp;
 extern char     UserChars[5];
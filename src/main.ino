@@ -1,6 +1,6 @@
 #include <Arduino.h>
 #include <debounce.h>
-#include "costable.h"
+#include "gateshapes.h"
 #include "DueArbitraryWaveformGeneratorV2.h"
 #include <Wire.h>
 #include <Adafruit_DS1841.h>
@@ -10,6 +10,10 @@
 // #define GAP_DURATION         25000   // ms between sounds
 // #define SOUND_DURATION        5000   // ms duration of sound to play
 // #define COSINE_PERIOD          500   // ms duration of cosine gate function, must be less than or equal to 1/2 SOUND_DURATION
+// #define RISE_SHAPE       GATE_COS2   // gate shapes (gateshapes.h): GATE_COS2 (= Hann, raised cosine), GATE_BLACKMAN, GATE_COSINE, GATE_LINEAR
+// #define FALL_SHAPE       GATE_COS2
+// #define POT_FADE_SHAPE   GATE_COS2   // pot fade for sounds the DAWG can't gate - read backwards, GATE_COS2 is the old costable.h (0.5 + 0.5 cos)
+// #define ONSET_PHASE              0   // degrees of the sine at which tones start & stop: 0 = rising zero crossing
 // #define SOUND_COUNT             18   // total number of samples to play
 // const uint8_t  r[SOUND_COUNT] = {5,1,7,2,3,6,0,8,4,7,3,8,6,0,2,5,4,1}; //fixed random order to play the volumes in
 
@@ -18,6 +22,10 @@
 #define GAP_DURATION         30000   // ms between sounds
 #define SOUND_DURATION        5000   // ms duration of sound to play
 #define COSINE_PERIOD          500   // ms duration of cosine gate function, must be less than or equal to 1/2 SOUND_DURATION
+#define RISE_SHAPE       GATE_COS2   // gate shapes (gateshapes.h): GATE_COS2 (= Hann, raised cosine), GATE_BLACKMAN, GATE_COSINE, GATE_LINEAR
+#define FALL_SHAPE       GATE_COS2
+#define POT_FADE_SHAPE   GATE_COS2   // pot fade for sounds the DAWG can't gate - read backwards, GATE_COS2 is the old costable.h (0.5 + 0.5 cos)
+#define ONSET_PHASE              0   // degrees of the sine at which tones start & stop: 0 = rising zero crossing
 #define SOUND_COUNT             11   // total number of samples to play
 const uint8_t  r[SOUND_COUNT] = {0,0,0,0,0,0,0,0,0,0,0};
 
@@ -25,8 +33,10 @@ const uint8_t  r[SOUND_COUNT] = {0,0,0,0,0,0,0,0,0,0,0};
 // These are given as amplitude ratios of the waveform, i.e. direct control on arduino
 // In theory, each -10 dB is a multiplier of 0.316227766 to amplitude
 // Range of usable coefficients is 1,000,000 to 489 (for minimum amplitude of 489/1,000,000 = 2/4096 for 12 bit DAC)
-// Coefficients for noise are up through 65535 and lowest three are sentinel values for altering volume with potentiometers
-const uint32_t volume_noise[9]  = {65535,23000,7300,2300,730,200,199,198,197};
+// Noise uses the same 1,000,000 scale with dithered gain, & the pots take over below NOISE_DIGITAL_MIN - see changeVolumeHelper()
+// The noise levels are +6.6 dB (x 2.138) on the old calibration, making up for the new colouring filter's lower output, so each
+// level plays at the SPL it was calibrated for. The loudest is above 1,000,000, so it clips as the old full volume noise did
+const uint32_t volume_noise[9]  = {2137962,750322,238145,75032,23815,6525,2063,652,207};
 const uint32_t volume_tone4[9]  = {460000,145000,46000,14500,5200,1900,800,505,491};
 const uint32_t volume_tone8[9]  = {320000,100000,32000,10250,3500,1400,580,495,489};
 const uint32_t volume_tone16[9] = {700000,225000,75000,23000,8500,2800,1200,525,492};
@@ -57,6 +67,9 @@ const uint32_t RECORDING_DURATION = SOUND_COUNT * (SOUND_DURATION + GAP_DURATION
 #define NOISE '4'
 
 #define USING_RELAY 0
+#define BAND_NOISE  0 // 1 = the 4, 8, 16 & 32 kHz buttons select octave band noise centred on that freq instead of a tone
+#define NOISE_SEED  0 // non-zero plays the same "frozen" noise token (from this seed) every time noise starts, 0 = TRNG noise
+#define TONE_BANK   0 // 1 = tones play from buffers rendered at boot (exact freq, switched without recalculating, gated & started at ONSET_PHASE), 0 = DAWG sine wave (default until the tone bank has been checked on a board)
 
 uint32_t soundAmplitude[SOUND_COUNT] = {0};
 unsigned long soundToStart[SOUND_COUNT] = {0};
@@ -65,6 +78,10 @@ unsigned long soundStartedAt = 0; //active playing sound, for convenience
 unsigned long soundStopsAt = 0; //active playing sound, for convenience
 unsigned long currentMillis = 0;
 unsigned long sequenceToStop = 0;
+bool soundGated = false; //the DAWG's gate is fading the active sound (sample exact), so the pots don't fade it
+bool gateOffPending = false; //the gate is turned off once the DAWG is playing silence - it's only on for sequence & test sounds
+uint32_t ttlSample = 0; //DAC sample playing when the TTL went high - the onset is reported relative to it
+bool onsetPending = false; //waiting for the DAWG to schedule the tone's onset
 
 char waveShape = SILENCE; // changing this here has no effect on startup value, startup is controlled by the DAWG library
 int32_t frequency = 0;
@@ -77,6 +94,10 @@ int8_t potTap = 0; //controls output of potentiometers, 0-127
 int8_t potTap_old = -1;
 int8_t potTap_min = 0;
 
+// Attenuator split for noise: digital gain down to NOISE_DIGITAL_MIN (about -50 dB), then the pots add 10 dB steps
+#define NOISE_DIGITAL_MIN 3000
+const int8_t potTap_steps[4] = {0, 75, 109, 125}; //both pots at these taps give 0, -10, -20 & -30 dB
+
 void updatePots(uint8_t tap) {
   if (tap != potTap_old) {
     ds0.setWiper(tap);
@@ -92,6 +113,11 @@ void changeWaveHelper(char shape) {
   ChangeWaveShape(true);
 }
 
+//tones from the tone bank are switched by pointer, so playing & silencing them costs no wave rebuild
+static bool usingToneBank() {
+  return TONE_BANK && waveShape == SINUSOIDAL;
+}
+
 void changeFreqHelper(uint16_t freq) {
   UserInput = freq; //set serial input to mimic e.g. '4000h' ie change to 4000 Hz frequency
   SetFreqPeriod();
@@ -100,45 +126,69 @@ void changeFreqHelper(uint16_t freq) {
   frequency = freq;
 }
 
+//noise & tone bank tones are played in DMA blocks, which the DAWG's gate fades per sample
+static bool usingGate() {
+  return usingToneBank() || waveShape == NOISE;
+}
+
+//pot fade level, 1000 (full) down to 0, j of GATE_POINTS through the fade - the rise read backwards, in the old costable.h's 1000 steps
+static uint16_t potFadeLevel(uint16_t j) {
+  return ((uint32_t) GateShapeRise(POT_FADE_SHAPE)[GATE_POINTS - j] * 1000 + 16384) / 32768;
+}
+
 //Expects a number between 489 and 1,000,000 used as a coefficient for amplitude
-//(or 10-65535 for noise)
+//(or 1-1,000,000 for noise)
 void changeVolumeHelper(uint32_t amplitude) {
   potTap_min = 0; //reset minimum by default, regardless of shape
-  if (waveShape == SINUSOIDAL) {
+  if (usingToneBank()) {
+    SetToneAmp(amplitude); //scales the tones into the spare buffer set & swaps - no wave rebuild, & the tone playing is undisturbed
+  } else if (waveShape == SINUSOIDAL) {
     SinAmp = amplitude/1000000.0; //sinamp is a float
     CreateWaveFull(0); //the 0 specifies waveshape 0, sinusoidal
   } else {
-    NoiseAmp = (uint16_t) amplitude; //noiseamp is a uint32_t
-    //noiseamp takes effect immediately, no need to rebuild wave
-
-    //hacky fix for getting the lowest volumes from noise: use the potentiometers
-    //lowest three volumes are amplitudes of 199,198,197
-    //both pots at 75 gives -10dB, both at 109 gives -20 dB, both at 125 gives -30 dB
-    if (amplitude == 199) potTap_min = 75;
-    if (amplitude == 198) potTap_min = 109;
-    if (amplitude == 197) potTap_min = 125;
+    //below NOISE_DIGITAL_MIN the digital gain stops at about -50 dB & the pots make up the rest in 10 dB steps
+    //the pots are only set here, before the sound plays - the fade still runs from 127 down to potTap_min
+    uint8_t step = 0;
+    uint32_t digital = amplitude;
+    while (step < 3 && digital > 0 && digital < NOISE_DIGITAL_MIN) {
+      step++;
+      digital = (uint64_t) digital * 3162278 / 1000000; //+10 dB
+    }
+    potTap_min = potTap_steps[step];
+    NoiseAmp = digital; //noiseamp takes effect at the next DMA block, no need to rebuild wave
   } 
+  if (usingGate()) updatePots(potTap_min); //set well before the sound, while silence is playing - they stay there while it plays
   volume = amplitude;
   Serial.print("Volume changed to "); Serial.print(volume); Serial.println("");
 }
 
 static void playSound(int i) {
   Serial.println("Sound playing");
+  SetGate(COSINE_PERIOD, RISE_SHAPE, FALL_SHAPE); //noise & tone bank sounds are faded per sample by the DAWG, silent until StartGate()
+  gateOffPending = false;
   digitalWrite(TTL_OUTPUT_PIN, HIGH);
-  changeWaveHelper(waveShape);
+  ttlSample = DacSampleNow();
+  onsetPending = usingToneBank();
+  if (!usingToneBank()) changeWaveHelper(waveShape); //noise starts streaming here, silent until StartGate()
   if (USING_RELAY) digitalWrite(RELAY_PIN, HIGH);
   soundStartedAt = millis(); //schedule, for cosine fade
   soundStopsAt = soundToStop[i];
+  soundGated = StartGate(soundStopsAt ? soundStopsAt - soundStartedAt : 0); //rise, hold & fall counted in samples - 0 holds until GateRelease() (test button)
+  if (usingToneBank()) SelectTone(frequency/1000); //after StartGate(), so the gate is already rising when the tone starts (at ONSET_PHASE in the next buffer) & the onset is its first audible sample
   soundToStart[i] = 0; //clear the assignment
 }
 
 static void silenceSound(int i) {
   Serial.println("Sound silenced"); 
-  changeWaveHelper(SILENCE); 
+  CloseGate(); //normally closed already - silences an aborted sound
+  if (usingToneBank()) SelectTone(0);
+  else changeWaveHelper(SILENCE); 
   digitalWrite(TTL_OUTPUT_PIN, LOW);
   if (USING_RELAY) digitalWrite(RELAY_PIN, LOW);
   soundStartedAt = 0; //clear the indication that sound is playing
   soundStopsAt = 0;
+  soundGated = false;
+  gateOffPending = true; //once the tone's stop is queued - the rest of the tone is silenced by the closed gate
   soundToStop[i] = 0; //clear the assignment     
 }
 
@@ -183,7 +233,12 @@ static void testHandler(uint8_t btnId, uint8_t btnState) {
     Serial.print("Released test button, test to stop in ");
     Serial.print(COSINE_PERIOD);
     Serial.println(" ms.");
-    soundToStop[0] = max(currentMillis, soundStartedAt+COSINE_PERIOD) + COSINE_PERIOD;
+    if (soundGated) {
+      GateRelease(); //falls now, or once the rise is complete
+      soundToStop[0] = currentMillis; //silenced once the gate has closed
+    } else {
+      soundToStop[0] = max(currentMillis, soundStartedAt+COSINE_PERIOD) + COSINE_PERIOD;
+    }
     soundStopsAt = soundToStop[0];
   }
 }
@@ -220,12 +275,25 @@ static void selectorHandler(uint8_t btnId, uint8_t btnState) {
   if (btnState == BTN_PRESSED) {
     if (btnId == 3) { //pink noise setting
       Serial.println("Selected pink noise");
+      StopToneBank(); //hand the DAC back to the DAWG, if a tone was selected before
       waveShape = NOISE; //wave shape 4 is noise
+      SetNoiseBand(0); //broadband
+      frequency = -1;
+    } else if (BAND_NOISE) {
+      Serial.print("Selected "); Serial.print(btnId); Serial.print(" kHz octave band noise."); Serial.println("");
+      StopToneBank();
+      waveShape = NOISE;
+      SetNoiseBand(btnId); //btnId specifies centre frequency in kHz
       frequency = -1;
     } else {
       Serial.print("Selected "); Serial.print(btnId); Serial.print(" kHz sinusoidal tone."); Serial.println("");
       waveShape = SINUSOIDAL; //wave shape 0 is sinusoidal
-      changeFreqHelper(btnId*1000); //btnId specifies frequency in kHz
+      if (TONE_BANK) {
+        frequency = btnId*1000; //btnId specifies frequency in kHz
+        StartToneBank(); //plays silence until playSound() - already running if a tone was selected before
+      } else {
+        changeFreqHelper(btnId*1000); //btnId specifies frequency in kHz
+      }
     }
     if (waveShape == NOISE) {
       changeVolumeHelper(volume_noise[0]);
@@ -300,8 +368,10 @@ void setup() {
   potTap = 127; // quiet (max resistance) | 0 is loud (min resistance)
   updatePots(potTap);
   Setup_DAWG(); //Due Arbitrary Waveform Generator - not my acronym haha  
+  SetOnsetPhase(ONSET_PHASE); //tone bank tones start & stop at this phase, exact to the sample
   if (ExactFreqMode) ToggleExactFreqMode(); //we DON'T want to be in exact mode, which has nasty harmonics at 32khz
   NoiseAmp = 0;
+  if (NOISE_SEED) SetNoiseSeed(NOISE_SEED);
 }
 
 void loop() { 
@@ -319,24 +389,34 @@ void loop() {
     if (!soundStartedAt && soundToStart[i] && (currentMillis > soundToStart[i])) {playSound(i);}
   }
 
+  uint32_t onset;
+  if (onsetPending && ToneOnset(&onset)) { //report where the tone really started, to align it with the TTL
+    onsetPending = false;
+    Serial.print("Onset at sample "); Serial.print(onset); Serial.print(", ");
+    Serial.print((int32_t) (onset - ttlSample)); Serial.print(" samples (");
+    Serial.print((int32_t) (onset - ttlSample) * 1000.0 / BlockSampleRate(), 3); Serial.println(" ms) after TTL");
+  }
+
   currentMillis = millis();
   elapsed = currentMillis - soundStartedAt; //float so we get reasonable math below rather than integer math
   remaining = soundStopsAt - currentMillis;
 
-  //play sound, fading up or down as needed
+  //play sound, fading up or down as needed - with the pots, if the gate isn't fading it
   static uint16_t j;
-  if (soundStartedAt && remaining == 0) { //min volume
+  if (soundGated) {
+    //the DAWG's gate fades the samples themselves
+  } else if (soundStartedAt && remaining == 0) { //min volume
     potTap = 127;
     //Serial.print("off ");
     updatePots(potTap);
   } else if (soundStartedAt && remaining <= COSINE_PERIOD) { //in cosine gate at end, fade down
-    j = constrain((COS_TABLE_SIZE-1) * remaining / COSINE_PERIOD, 0, COS_TABLE_SIZE-1);
-    potTap = potTap_min + (127-potTap_min) * pgm_read_word_near(cosTable + j) / COS_TABLE_AMPLITUDE;
+    j = constrain(GATE_POINTS * remaining / COSINE_PERIOD, 0, GATE_POINTS);
+    potTap = potTap_min + (127-potTap_min) * potFadeLevel(j) / 1000;
     //Serial.print("down ");
     updatePots(potTap);
   } else if (soundStartedAt && elapsed <= COSINE_PERIOD) { //in cosine gate at start, fade up
-    j = constrain((COS_TABLE_SIZE-1) * elapsed / COSINE_PERIOD, 0, COS_TABLE_SIZE-1);
-    potTap = potTap_min + (127-potTap_min) * pgm_read_word_near(cosTable + j) / COS_TABLE_AMPLITUDE;
+    j = constrain(GATE_POINTS * elapsed / COSINE_PERIOD, 0, GATE_POINTS);
+    potTap = potTap_min + (127-potTap_min) * potFadeLevel(j) / 1000;
     //Serial.print("up ");
     updatePots(potTap);
   } else if (soundStartedAt && elapsed > COSINE_PERIOD && elapsed < remaining) { //full volume
@@ -347,9 +427,13 @@ void loop() {
 
   for (unsigned int i=0; i < SOUND_COUNT; i++) {
     //silence sound
-    if (soundStartedAt && soundToStop[i] && (currentMillis >= soundToStop[i])) {silenceSound(i);}
+    if (soundStartedAt && soundToStop[i] && (currentMillis >= soundToStop[i]) && GateClosed()) {silenceSound(i);} //the gate counts from the first block it fades, so it closes a few ms after soundToStop
     if (sequenceToStop && (currentMillis >= sequenceToStop)) {stopSequence();}
   }
+  if (gateOffPending && ToneSilent()) { //gate off between sounds, so the DAWG's own serial commands aren't silenced
+    SetGate(0, RISE_SHAPE, FALL_SHAPE);
+    gateOffPending = false;
+  }
   
 
   Loop_DAWG(); //Due Arbitrary Waveform Generator - not my acronym haha
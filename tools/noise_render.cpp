@@ -0,0 +1,293 @@
+// Host-side noise renderer & PSD benchmark - runs the Due's noise pipeline (include/noisedsp.h) on Linux
+//
+// Renders frozen noise (the same samples as ns on the Due, for the same seed) to a WAV or raw file, measures its
+// power spectrum (Welch, Hann window, 50% overlap) in third octave bands, fits the slope in dB/octave & times the
+// pipeline in samples per second. Each band is also compared with the 1/f target for the colour - at the speaker,
+// through the fitted model in speakereq.h, when there's a speaker measurement - so -e shows what the EQ corrects.
+// Exits with 1 if the slope is further than the tolerance from the colour asked for, so it can be run as a
+// build-time check of colour accuracy - tools/noisecheck.py runs it before every PlatformIO build.
+//
+// build:  g++ -O2 -std=gnu++14 -Iinclude tools/noise_render.cpp -o noise_render
+// usage:  ./noise_render [-s secs] [-c colour] [-b band] [-f taps.txt] [-e] [-a amp] [-d divisor] [-r seed] [-t tol dB/oct] [-g n] [-o out.wav|out.raw]
+//         colour 0 to 1000 as nc (500 = pink), band 1 to 4 = 4, 8, 16 or 32 kHz octave band (0 = broadband),
+//         -f = FIR filter taps (Q15, as nf - tools/noisefir.py writes them) instead of the colour filter,
+//         -e = speaker EQ on (needs a measured speakereq.h), -a = amplitude as na (1000000 = 0 dB) through the dithered gain stage, instead of
+//         full scale without dither. A .raw file holds the 12 bit DAC values as 16 bit little endian words,
+//         -g = print the first n samples (DAC steps from mid-scale) - tools/noisecheck.py compares them with tools/noise_golden.txt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <complex>
+#include <vector>
+#include "noisedsp.h"
+
+#define PSD_SIZE   16384 // FFT size for Welch's method
+#define FIT_LOW    1000.0 // slope fitted over third octave bands from FIT_LOW to FIT_HIGH (Hz)
+#define FIT_HIGH   40000.0
+
+static void Fft(std::vector<std::complex<double> > &a) // in-place radix 2
+{
+  size_t n = a.size();
+  for (size_t i = 1, j = 0; i < n; i++)
+  {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(a[i], a[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1)
+  {
+    std::complex<double> step = std::polar(1.0, -2 * M_PI / len);
+    for (size_t i = 0; i < n; i += len)
+    {
+      std::complex<double> w = 1;
+      for (size_t j = 0; j < len / 2; j++, w *= step)
+      {
+        std::complex<double> u = a[i + j], v = a[i + j + len / 2] * w;
+        a[i + j] = u + v;
+        a[i + j + len / 2] = u - v;
+      }
+    }
+  }
+}
+
+static std::vector<double> Welch(const std::vector<int16_t> &x) // averaged power spectrum, bins 0 to PSD_SIZE / 2
+{
+  std::vector<double> psd(PSD_SIZE / 2 + 1, 0), window(PSD_SIZE);
+  for (int i = 0; i < PSD_SIZE; i++) window[i] = 0.5 - 0.5 * cos(2 * M_PI * i / PSD_SIZE);
+  int segments = 0;
+  for (size_t start = 0; start + PSD_SIZE <= x.size(); start += PSD_SIZE / 2, segments++)
+  {
+    std::vector<std::complex<double> > a(PSD_SIZE);
+    for (int i = 0; i < PSD_SIZE; i++) a[i] = x[start + i] * window[i];
+    Fft(a);
+    for (int i = 0; i <= PSD_SIZE / 2; i++) psd[i] += std::norm(a[i]);
+  }
+  for (double &p : psd) p /= segments;
+  return psd;
+}
+
+#ifdef SPEAKER_F0
+static double SpeakerDb(double f) // level (dB) at the speaker, from the 2nd order high-pass fitted by tools/speakereq.py
+{
+  double x = f * f / (SPEAKER_F0 * SPEAKER_F0);
+  return 10 * log10(x * x / ((1 - x) * (1 - x) + x / (SPEAKER_Q0 * SPEAKER_Q0)));
+}
+#endif
+
+static bool WriteFile(const char *name, const std::vector<int16_t> &x, double rate) // 16 bit mono WAV, or raw 12 bit DAC values
+{
+  FILE *f = fopen(name, "wb");
+  if (!f) return false;
+  size_t len = strlen(name);
+  bool wav = len < 4 || strcmp(name + len - 4, ".raw") != 0;
+  if (wav)
+  {
+    uint32_t bytes = x.size() * 2, rateHz = lround(rate), byteRate = rateHz * 2, size = 36 + bytes, fmtSize = 16;
+    uint16_t format = 1, channels = 1, align = 2, bits = 16;
+    fwrite("RIFF", 1, 4, f); fwrite(&size, 4, 1, f); fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmtSize, 4, 1, f); fwrite(&format, 2, 1, f); fwrite(&channels, 2, 1, f); fwrite(&rateHz, 4, 1, f);
+    fwrite(&byteRate, 4, 1, f); fwrite(&align, 2, 1, f); fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f); fwrite(&bytes, 4, 1, f);
+  }
+  for (int16_t v : x)
+  {
+    uint16_t w = wav ? (uint16_t) (v * 16) : (uint16_t) (v + 2048); // WAV: 12 bits scaled to 16, raw: DAC value
+    fwrite(&w, 2, 1, f);
+  }
+  return fclose(f) == 0;
+}
+
+int main(int argc, char *argv[])
+{
+  double secs = 10, tolerance = 0.25;
+  int colour = 500, band = 0, divisor = NOISE_DIVISOR, golden = 0;
+  long amp = -1;
+  uint32_t seed = 1;
+  bool eq = false;
+  const char *out = 0, *firFile = 0;
+  for (int i = 1; i < argc; i++)
+  {
+    bool more = i + 1 < argc;
+    if (!strcmp(argv[i], "-e")) eq = true;
+    else if (more && !strcmp(argv[i], "-s")) secs = atof(argv[++i]);
+    else if (more && !strcmp(argv[i], "-c")) colour = atoi(argv[++i]);
+    else if (more && !strcmp(argv[i], "-b")) band = atoi(argv[++i]);
+    else if (more && !strcmp(argv[i], "-a")) amp = atol(argv[++i]);
+    else if (more && !strcmp(argv[i], "-f")) firFile = argv[++i];
+    else if (more && !strcmp(argv[i], "-d")) divisor = atoi(argv[++i]);
+    else if (more && !strcmp(argv[i], "-r")) seed = strtoul(argv[++i], 0, 0);
+    else if (more && !strcmp(argv[i], "-t")) tolerance = atof(argv[++i]);
+    else if (more && !strcmp(argv[i], "-g")) golden = atoi(argv[++i]);
+    else if (more && !strcmp(argv[i], "-o")) out = argv[++i];
+    else
+    {
+      fprintf(stderr, "usage: %s [-s secs] [-c colour 0-1000] [-b band 0-4] [-f taps.txt] [-e] [-a amp] [-d divisor] [-r seed] [-t tol] [-g n] [-o out.wav|out.raw]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (colour < 0 || colour > 1000 || band < 0 || band > NOISE_BANDS || amp > NOISE_AMP_MAX || divisor < 42 || secs <= 0)
+  {
+    fprintf(stderr, "colour must be 0 to 1000, band 0 to %d, amp up to %d, divisor 42 or more & secs above 0\n", NOISE_BANDS, NOISE_AMP_MAX);
+    return 2;
+  }
+  #ifndef SPEAKER_F0
+  if (eq)
+  {
+    fprintf(stderr, "no speaker EQ - include/speakereq.h has no speaker measurement yet (see tools/speakereq.py)\n");
+    return 2;
+  }
+  #endif
+  double rate = 42000000.0 / divisor;
+
+  // the same designs the Due makes at compile time, but for the divisor given here
+  NoisePoleCoefs   poles     = NoisePoleDesign(rate);
+  NoiseColourCoefs colourSet = NoiseColourDesign(colour, rate);
+  NoiseBandTable   bands     = NoiseBandDesign(rate);
+  NoiseGenerator noise = NoiseGenerator(); // value-initialised, then the filters chosen
+  noise.poles  = &poles;
+  noise.colour = &colourSet;
+  noise.band   = band ? &bands.band[band - 1] : 0;
+  #ifdef SPEAKER_F0
+  NoiseBiquadCoefs speakerEq = SpeakerEqDesign(SPEAKER_F0, SPEAKER_Q0, SPEAKER_FP, SPEAKER_QP, rate);
+  noise.eq     = eq ? &speakerEq : 0;
+  #endif
+  NoiseReset(&noise);
+  NoiseRng rng;
+  NoiseRngSeed(&rng, seed);
+  NoiseRngSource white = {&rng};
+  static NoiseFir fir;
+  if (firFile)
+  {
+    FILE *f = fopen(firFile, "r");
+    if (!f) { fprintf(stderr, "can't read %s\n", firFile); return 2; }
+    int tap;
+    long sum = 0;
+    while (fir.taps < NOISE_FIR_TAPS && fscanf(f, " %d%*[ ,]", &tap) == 1) { fir.h[fir.taps++] = tap; sum += labs(tap); }
+    fclose(f);
+    if (!fir.taps || sum >= NOISE_FIR_SUM_MAX) { fprintf(stderr, "%s needs 1 to %d taps with a sum of |taps| below 32.0\n", firFile, NOISE_FIR_TAPS); return 2; }
+  }
+
+  std::vector<int16_t> x((size_t) (secs * rate));
+  int clipped = 0;
+  auto start = std::chrono::steady_clock::now();
+  if (fir.taps) // in DMA sized blocks, as FillNoiseBlock()
+  {
+    int32_t gain = NoiseGain(amp < 0 ? 1000000 : amp);
+    uint16_t block[512];
+    for (size_t i = 0; i < x.size(); i += 512)
+    {
+      size_t n = x.size() - i < 512 ? x.size() - i : 512;
+      NoiseFirRender(&noise, &fir, white, block, n, gain);
+      for (size_t j = 0; j < n; j++) x[i + j] = block[j] - NOISE_MIDSCALE;
+    }
+  }
+  else if (amp < 0) for (size_t i = 0; i < x.size(); i++) x[i] = NoiseRender(&noise, white);
+  else
+  {
+    int32_t gain = NoiseGain(amp);
+    for (size_t i = 0; i < x.size(); i++) x[i] = NoiseOutput(&noise, white, gain) - NOISE_MIDSCALE;
+  }
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double sumSq = 0;
+  for (int16_t v : x)
+  {
+    sumSq += (double) v * v;
+    if (v == -2048 || v == 2047) clipped++;
+  }
+  double rms = sqrt(sumSq / x.size());
+
+  if (fir.taps) printf("Noise: FIR filter, %d taps from %s, speaker EQ %s, seed %u\n", fir.taps, firFile, eq ? "on" : "off", seed);
+  else printf("Noise: colour %d, %s, speaker EQ %s, seed %u\n", colour, band ? "octave band" : "broadband", eq ? "on" : "off", seed);
+  if (band) printf("   Band centre: %.0f kHz\n", NOISE_BAND0_FREQ / 1000 * (1 << (band - 1)));
+  printf("   Sample rate: %.0f Hz (divisor %d), %zu samples (%.2f Secs)\n", rate, divisor, x.size(), x.size() / rate);
+  if (amp >= 0) printf("   Amplitude: %ld (%.1f dB), dithered\n", amp, 20 * log10(amp / 1e6));
+  printf("   RMS: %.2f DAC steps (%.1f dB re %d), clipped samples: %.4f%%\n", rms, 20 * log10(rms / NOISE_RMS), NOISE_RMS, 100.0 * clipped / x.size());
+  printf("   Host throughput: %.1f M samples/s (%.0fx real time)\n", x.size() / elapsed / 1e6, x.size() / elapsed / rate);
+  if (golden > 0)
+  {
+    printf("   First %d samples:", golden);
+    for (size_t i = 0; i < x.size() && i < (size_t) golden; i++) printf(" %d", x[i]);
+    printf("\n");
+  }
+  if (out)
+  {
+    if (!WriteFile(out, x, rate)) { fprintf(stderr, "can't write %s\n", out); return 2; }
+    printf("   Written to %s\n", out);
+  }
+  if (x.size() < PSD_SIZE)
+  {
+    printf("   Too short for a PSD - at least %d samples needed\n", PSD_SIZE);
+    return 0;
+  }
+
+  // third octave band levels, relative to the first band
+  std::vector<double> psd = Welch(x);
+  std::vector<double> octaves, levels;
+  double high = fmin(FIT_HIGH, rate * 0.4);
+  for (double f = FIT_LOW; f <= high * 1.001; f *= pow(2, 1 / 3.0))
+  {
+    double sum = 0;
+    int bins = 0;
+    for (int i = 1; i <= PSD_SIZE / 2; i++)
+    {
+      double fi = i * rate / PSD_SIZE;
+      if (fi >= f * pow(2, -1 / 6.0) && fi < f * pow(2, 1 / 6.0)) { sum += psd[i]; bins++; }
+    }
+    if (!bins) continue;
+    octaves.push_back(log2(f / FIT_LOW));
+    levels.push_back(10 * log10(sum / bins));
+  }
+  // against the 1/f target for the colour, lined up at the top band (where the speaker is flat & the EQ doesn't change
+  // the shape). With a speaker measurement the level is taken at the speaker, so this is what the listener hears
+  double expected = 3.0 * (colour - 1000) / 500; // white 0 dB, pink -3 dB, brown -6 dB per octave
+  bool target = !band && !fir.taps;
+  std::vector<double> heard(levels);
+  #ifdef SPEAKER_F0
+  for (size_t i = 0; i < heard.size(); i++) heard[i] += SpeakerDb(FIT_LOW * pow(2, octaves[i]));
+  const char *where = "at speaker";
+  #else
+  const char *where = "at DAC";
+  #endif
+  double worst = 0, worstFreq = 0;
+  if (target) printf("\n   Freq (Hz)   Level (dB)   %s vs 1/f target (dB)\n", where);
+  else printf("\n   Freq (Hz)   Level (dB)\n");
+  for (size_t i = 0; i < levels.size(); i++)
+  {
+    double f = FIT_LOW * pow(2, octaves[i]);
+    printf("   %9.0f   %10.2f", f, levels[i] - levels[0]);
+    if (target)
+    {
+      double error = heard[i] - heard.back() - expected * (octaves[i] - octaves.back());
+      if (fabs(error) > fabs(worst)) { worst = error; worstFreq = f; }
+      printf("   %+10.2f", error);
+    }
+    printf("\n");
+  }
+  if (target) printf("\n   Largest error %s vs the 1/f target: %+.2f dB at %.0f Hz\n", where, worst, worstFreq);
+
+  // least squares line through the band levels
+  double mx = 0, my = 0, sxy = 0, sxx = 0, dev = 0;
+  for (size_t i = 0; i < levels.size(); i++) { mx += octaves[i]; my += levels[i]; }
+  mx /= levels.size();
+  my /= levels.size();
+  for (size_t i = 0; i < levels.size(); i++)
+  {
+    sxy += (octaves[i] - mx) * (levels[i] - my);
+    sxx += (octaves[i] - mx) * (octaves[i] - mx);
+  }
+  double slope = sxy / sxx;
+  for (size_t i = 0; i < levels.size(); i++) dev = fmax(dev, fabs(levels[i] - my - slope * (octaves[i] - mx)));
+  printf("%s   Slope %.0f Hz to %.0f Hz: %.2f dB/octave, max deviation from fit %.2f dB\n", target ? "" : "\n", FIT_LOW, high, slope, dev);
+  if (band || eq || fir.taps)
+  {
+    printf("   Slope not checked - band filter, FIR filter or speaker EQ in use\n");
+    return 0;
+  }
+  bool pass = fabs(slope - expected) <= tolerance;
+  printf("   Expected %.2f dB/octave: %s (tolerance %.2f)\n", expected, pass ? "PASS" : "FAIL", tolerance);
+  return pass ? 0 : 1;
+}
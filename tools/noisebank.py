@@ -0,0 +1,165 @@
+# PlatformIO pre-build script: pre-renders a pink noise token into flash (noisebank.h) for NoiseSource 2
+#
+# The token is rendered with the same integer colour filter & seeded generator as include/noisedsp.h, at the
+# NOISE_DIVISOR in build_flags unless custom_noisebank_divisor is set, so it matches frozen noise (ns) with the same
+# seed & colour. Its length is set by flash: 2 bytes per sample, so the 131072 sample default (256 kBytes) is 0.87
+# Secs at 150kHz & then repeats. Settings come from the custom_noisebank_* options in platformio.ini. noisebank.h is
+# written to the build directory & only re-rendered when the settings change.
+
+import os
+import re
+
+Import("env")
+
+SECTIONS = 6        # these must match include/noisedsp.h
+POLE0 = 150.0
+POLE_RATIO = 3.0
+LN_RATIO = 1.0986122886681098
+RMS = 600
+MASK32 = 0xFFFFFFFF
+
+
+def option(name, default):
+    return int(env.GetProjectOption("custom_noisebank_" + name, default))
+
+
+# filter design - the same steps as the constexpr functions in noisedsp.h, so the coefficients are bit-identical
+
+def cx_exp(x):
+    halvings = 0
+    while x > 0.5 or x < -0.5:
+        x /= 2
+        halvings += 1
+    term = total = 1.0
+    for i in range(1, 20):
+        term *= x / i
+        total += term
+    for i in range(halvings):
+        total *= total
+    return total
+
+
+def cx_sqrt(x):
+    r = x if x > 1 else 1.0
+    for i in range(60):
+        r = (r + x / r) / 2
+    return r
+
+
+def cx_q31(f):
+    return 0x7FFFFFFF if f >= 1.0 else int(f * 2147483648.0)
+
+
+def pole(k, rate):
+    freq = POLE0
+    for i in range(k):
+        freq *= POLE_RATIO
+    return cx_exp(-2 * 3.141592653589793 * freq / rate)
+
+
+def zero(k, colour, rate):
+    slope = (1000 - colour) / 1000.0
+    freq = POLE0 * cx_exp(slope * LN_RATIO)
+    for i in range(k):
+        freq *= POLE_RATIO
+    return cx_exp(-2 * 3.141592653589793 * freq / rate)
+
+
+def design(colour, rate): # NoisePoleDesign() & NoiseColourDesign()
+    colour = min(colour, 1000)
+    a = [pole(k, rate) for k in range(SECTIONS)]
+    b = [zero(k, colour, rate) for k in range(SECTIONS)]
+    r = []
+    for k in range(SECTIONS):
+        num = den = 1.0
+        for j in range(SECTIONS):
+            num *= 1 - b[j] / a[k]
+            if j != k:
+                den *= 1 - a[j] / a[k]
+        r.append(num / den)
+    power = 1.0
+    for k in range(SECTIONS):
+        for j in range(SECTIONS):
+            power += r[k] * r[j] * a[k] * a[j] / (1 - a[k] * a[j])
+    return cx_q31(RMS / (1182.0 * cx_sqrt(power))), [cx_q31(x) for x in a], [cx_q31(x) for x in b]
+
+
+def rotl(x, k):
+    return ((x << k) | (x >> (32 - k))) & MASK32
+
+
+def white(seed): # NoiseRngSeed() & NoiseRngWhite()
+    s = []
+    for i in range(4):
+        seed = (seed + 0x9E3779B9) & MASK32
+        z = seed
+        z = ((z ^ (z >> 16)) * 0x85EBCA6B) & MASK32
+        z = ((z ^ (z >> 13)) * 0xC2B2AE35) & MASK32
+        s.append(z ^ (z >> 16))
+    while True:
+        result = (rotl((s[1] * 5) & MASK32, 7) * 9) & MASK32
+        t = (s[1] << 9) & MASK32
+        s[2] ^= s[0]
+        s[3] ^= s[1]
+        s[1] ^= s[2]
+        s[0] ^= s[3]
+        s[2] ^= t
+        s[3] = rotl(s[3], 11)
+        for half in (result & 0xFFFF, result >> 16):
+            yield half - 0x10000 if half & 0x8000 else half
+
+
+def render(samples, colour, rate, seed): # NoiseColourFilter() + HALFRESOL
+    gain, a, b = design(colour, rate)
+    y = [0] * SECTIONS
+    last_in = 0
+    source = white(seed)
+    out = []
+    for i in range(samples):
+        v = ((next(source) << 8) * gain) >> 31
+        prev = last_in
+        last_in = v
+        for k in range(SECTIONS):
+            n = v - ((b[k] * prev) >> 31) + ((a[k] * y[k]) >> 31)
+            prev = y[k]
+            y[k] = n
+            v = n
+        out.append(min(max(v >> 12, -2048), 2047) + 2048)
+    return out
+
+
+flags = env.GetProjectOption("build_flags", "")
+if not isinstance(flags, str):
+    flags = " ".join(flags)
+found = re.search(r"NOISE_DIVISOR=(\d+)", flags)
+samples = option("samples", 131072)
+divisor = option("divisor", found.group(1) if found else 280) # NOISE_RATE - the default in noisedsp.h if not in build_flags
+colour = option("colour", 500)
+seed = option("seed", 1)
+rate = 42000000.0 / divisor
+settings = "// samples %d, divisor %d, colour %d, seed %d" % (samples, divisor, colour, seed)
+
+path = os.path.join(env.subst("$BUILD_DIR"), "noisebank")
+header = os.path.join(path, "noisebank.h")
+if not os.path.isdir(path):
+    os.makedirs(path)
+old = ""
+if os.path.isfile(header):
+    with open(header) as f:
+        f.readline()
+        old = f.readline().strip()
+script = os.path.join(env.subst("$PROJECT_DIR"), "tools", "noisebank.py")
+if old != settings or os.path.getmtime(header) < os.path.getmtime(script): # re-render if settings or this script have changed
+    print("Rendering noise bank: %d samples at %.0f Hz (%.2f Secs)" % (samples, rate, samples / rate))
+    data = render(samples, colour, rate, seed)
+    with open(header, "w") as f:
+        f.write("// Pre-rendered noise token - generated by tools/noisebank.py, do not edit\n")
+        f.write(settings + "\n")
+        f.write("#define NOISEBANK_SAMPLES %d\n" % samples)
+        f.write("#define NOISEBANK_DIVISOR %d // 42 MHz / %d = %.0f Hz playback rate\n" % (divisor, divisor, rate))
+        f.write("const uint16_t NoiseBank[NOISEBANK_SAMPLES] = {\n")
+        for i in range(0, samples, 16):
+            f.write(", ".join(str(x) for x in data[i:i + 16]) + ",\n")
+        f.write("};\n")
+
+env.Append(CPPPATH=[path], CPPDEFINES=["NOISEBANK"])
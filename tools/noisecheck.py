@@ -0,0 +1,114 @@
+# PlatformIO pre-build script: checks the noise colour filter on the host before the Due is built
+#
+# Builds tools/noise_render.cpp with the host C++ compiler & renders frozen white, pink & brown noise at the
+# NOISE_DIVISOR in build_flags. The build stops if the slope of any of them (dB/octave, from a Welch PSD) is further
+# than custom_noisecheck_tolerance from the colour's target, or if the first samples of any of them (seed 1, at
+# GOLDEN_DIVISOR whatever the build's NOISE_DIVISOR) differ from tools/noise_golden.txt - the slope only catches a
+# filter that's badly wrong, the golden samples catch any change to the pipeline's output. Settings come from the
+# custom_noisecheck_* options in platformio.ini. Only re-run when the settings, noise_render.cpp, the golden file or
+# the noise headers change. After an intended change to the output, rewrite the golden file with
+# custom_noisecheck_golden_write = 1 (for one build), check the slopes still pass & commit it.
+
+import os
+import re
+import subprocess
+
+Import("env")
+
+COLOURS = (1000, 500, 30) # white, pink & brown - as nw, np & nb
+GOLDEN_DIVISOR = 280      # the golden samples are always rendered at 150kHz & seed 1, so they don't depend on build_flags
+GOLDEN_SEED = 1
+GOLDEN_SAMPLES = 64
+
+
+def option(name, default):
+    return env.GetProjectOption("custom_noisecheck_" + name, default)
+
+
+def stop(message):
+    print("Noise check FAILED: " + message)
+    print("(set custom_noisecheck = 0 in platformio.ini to build without the check)")
+    env.Exit(1)
+
+
+if int(env.GetProjectOption("custom_noisecheck", 1)): # 0 = skip the check
+    flags = env.GetProjectOption("build_flags", "")
+    if not isinstance(flags, str):
+        flags = " ".join(flags)
+    found = re.search(r"NOISE_DIVISOR=(\d+)", flags)
+    divisor = int(found.group(1)) if found else 280 # the default in noisedsp.h
+    tolerance = float(option("tolerance", 0.25))
+    secs = float(option("secs", 4))
+    cxx = option("cxx", "g++")
+    write = int(option("golden_write", 0))
+    settings = "divisor %d, tolerance %.2f, secs %.1f, colours %s" % (divisor, tolerance, secs, COLOURS)
+
+    project = env.subst("$PROJECT_DIR")
+    golden = os.path.join(project, "tools", "noise_golden.txt")
+    sources = [os.path.join(project, "tools", "noise_render.cpp"), os.path.join(project, "tools", "noisecheck.py"), golden]
+    sources += [os.path.join(project, "include", name) for name in ("noisedsp.h", "speakereq.h", "cxmath.h")]
+    path = os.path.join(env.subst("$BUILD_DIR"), "noisecheck")
+    stamp = os.path.join(path, "passed")
+    renderer = os.path.join(path, "noise_render")
+    if not os.path.isdir(path):
+        os.makedirs(path)
+    old = ""
+    if os.path.isfile(stamp):
+        with open(stamp) as f:
+            old = f.readline().strip()
+    if write or old != settings or any(os.path.getmtime(stamp) < os.path.getmtime(s) for s in sources if os.path.isfile(s)):
+        if os.path.isfile(stamp):
+            os.remove(stamp)
+        print("Checking noise colour slopes at %.0f Hz (divisor %d)" % (42000000.0 / divisor, divisor))
+        try:
+            subprocess.check_call([cxx, "-O2", "-std=gnu++14", "-I" + os.path.join(project, "include"), sources[0], "-o", renderer])
+        except (OSError, subprocess.CalledProcessError) as e:
+            stop("can't build noise_render with %s (%s) - set custom_noisecheck_cxx to the host C++ compiler" % (cxx, e))
+        for colour in COLOURS:
+            run = subprocess.run([renderer, "-d", str(divisor), "-c", str(colour), "-s", str(secs), "-t", str(tolerance)],
+                                 stdout=subprocess.PIPE, universal_newlines=True)
+            result = [line.strip() for line in run.stdout.splitlines() if "Expected" in line]
+            print("  colour %4d: %s" % (colour, result[0] if result else "no result"))
+            if run.returncode != 0:
+                stop("colour %d is outside the tolerance - see tools/noise_render.cpp\n%s" % (colour, run.stdout))
+
+        expected = {}
+        if not write:
+            try:
+                with open(golden) as f:
+                    for line in f:
+                        if line.strip() and not line.startswith("#"):
+                            colour, values = line.split(":", 1)
+                            expected[int(colour)] = values.split()
+            except (OSError, ValueError) as e:
+                stop("can't read %s (%s)" % (golden, e))
+        rendered = []
+        for colour in COLOURS:
+            run = subprocess.run([renderer, "-d", str(GOLDEN_DIVISOR), "-r", str(GOLDEN_SEED), "-c", str(colour),
+                                  "-s", "0.01", "-g", str(GOLDEN_SAMPLES)], stdout=subprocess.PIPE, universal_newlines=True)
+            result = [line.split(":", 1)[1].split() for line in run.stdout.splitlines() if "First" in line]
+            if run.returncode != 0 or not result:
+                stop("noise_render gave no samples for colour %d\n%s" % (colour, run.stdout))
+            rendered.append("%d: %s" % (colour, " ".join(result[0])))
+            if write:
+                continue
+            if colour not in expected:
+                stop("colour %d is missing from %s" % (colour, golden))
+            wrong = [i for i, (a, b) in enumerate(zip(result[0], expected[colour])) if a != b]
+            if wrong or len(result[0]) != len(expected[colour]):
+                first = wrong[0] if wrong else min(len(result[0]), len(expected[colour]))
+                stop("colour %d's first samples differ from %s at sample %d - if the change is intended, rewrite it with "
+                     "custom_noisecheck_golden_write = 1" % (colour, golden, first))
+        if write:
+            with open(golden, "w") as f:
+                f.write("# First %d samples (DAC steps from mid-scale) of frozen noise, seed %d, divisor %d (%.0f Hz), full scale,\n"
+                        % (GOLDEN_SAMPLES, GOLDEN_SEED, GOLDEN_DIVISOR, 42000000.0 / GOLDEN_DIVISOR))
+                f.write("# per colour - tools/noisecheck.py stops the build if noise_render differs. Written with\n")
+                f.write("# custom_noisecheck_golden_write = 1 - only rewrite it for an intended change to the noise output\n")
+                for line in rendered:
+                    f.write(line + "\n")
+            print("  golden samples written to %s" % golden)
+        else:
+            print("  golden samples: match %s" % os.path.basename(golden))
+        with open(stamp, "w") as f:
+            f.write(settings + "\n")
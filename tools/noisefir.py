@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# FIR filter design for the noise generator's uploaded filter (nf over serial)
+#
+# Designs a linear phase FIR filter (window method) that shapes the Due's white noise to a target spectrum, scaled
+# to the same RMS level as the colour filter, & prints the serial command that uploads it. Targets are pink noise
+# with an optional notch or high-pass, or any response from a freq,dB CSV file - optionally corrected for a measured
+# speaker response (same CSV format as tools/speakereq.py). The taps can also be checked on the host with
+# noise_render -f taps.txt. The Due prints the max taps that fit at each sample rate when they're uploaded.
+#
+# usage: python3 tools/noisefir.py [--taps N] [--divisor D] [--notch Hz] [--width oct] [--highpass Hz]
+#                                  [--csv target.csv] [--speaker response.csv] [--out taps.txt]
+
+import argparse
+import math
+
+TAPS_MAX = 128      # these must match include/noisedsp.h
+RMS = 600
+WHITE_RMS = 2048 / math.sqrt(3) # 12 bit white noise fed to the FIR filter
+SUM_MAX = 32.0
+GRID = 4096         # points in the ideal response
+EST_SAMPLE = 30     # estimated Due cycles per sample & per tap - the Due measures these when the taps are uploaded
+EST_TAP = 5
+BUDGET = 75         # % CPU load allowed - as NOISE_FIR_BUDGET
+
+
+def load(path): # freq,dB points
+    points = []
+    with open(path) as f:
+        for line in f:
+            line = line.split("#")[0].strip()
+            if line:
+                freq, db = line.split(",")
+                points.append((float(freq), float(db)))
+    return sorted(points)
+
+
+def interp_db(points, f): # linear in log freq, held flat outside the points
+    if f <= points[0][0]:
+        return points[0][1]
+    for (f0, d0), (f1, d1) in zip(points, points[1:]):
+        if f <= f1:
+            return d0 + (d1 - d0) * math.log(f / f0) / math.log(f1 / f0)
+    return points[-1][1]
+
+
+def target(f, args, flat_below): # target amplitude (linear)
+    f = max(f, flat_below)
+    if args.csv:
+        a = 10 ** (interp_db(args.csv, f) / 20)
+    else:
+        a = 1 / math.sqrt(f / 1000) # pink
+    if args.notch:
+        q = math.sqrt(2 ** args.width) / (2 ** args.width - 1)
+        d = f * f - args.notch ** 2
+        a *= abs(d) / math.sqrt(d * d + (f * args.notch / q) ** 2)
+    if args.highpass:
+        x = (f / args.highpass) ** 2
+        a *= x / math.sqrt(1 + x * x) # 2nd order Butterworth
+    if args.speaker:
+        a *= 10 ** (min(12, -interp_db(args.speaker, f)) / 20) # undo the speaker's response, boosting by up to 12 dB
+    return a
+
+
+def design(args, rate):
+    n = args.taps
+    flat_below = rate / n # the filter can't resolve detail finer than this
+    t = [target(rate / 2 * k / (GRID // 2), args, flat_below) for k in range(GRID // 2 + 1)]
+    h = []
+    for i in range(n):
+        m = i - (n - 1) / 2
+        v = t[0] + t[GRID // 2] * math.cos(math.pi * m)
+        for k in range(1, GRID // 2):
+            v += 2 * t[k] * math.cos(2 * math.pi * k * m / GRID)
+        window = 0.42 - 0.5 * math.cos(2 * math.pi * (i + 0.5) / n) + 0.08 * math.cos(4 * math.pi * (i + 0.5) / n) # Blackman
+        h.append(v / GRID * window)
+    scale = RMS / (WHITE_RMS * math.sqrt(sum(x * x for x in h)))
+    return [x * scale for x in h]
+
+
+def response_db(h, f, rate):
+    re = sum(x * math.cos(2 * math.pi * f * i / rate) for i, x in enumerate(h))
+    im = sum(x * math.sin(2 * math.pi * f * i / rate) for i, x in enumerate(h))
+    return 10 * math.log10(max(re * re + im * im, 1e-20))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="FIR filter design for uploaded noise filters (nf)")
+    parser.add_argument("--taps", type=int, help="default: the most that fit in %d%% CPU load (estimated)" % BUDGET)
+    parser.add_argument("--divisor", type=int, default=280, help="NOISE_DIVISOR in platformio.ini - 42 MHz / divisor sample rate")
+    parser.add_argument("--notch", type=float, help="notch centre freq (Hz)")
+    parser.add_argument("--width", type=float, default=0.5, help="notch -3 dB width in octaves")
+    parser.add_argument("--highpass", type=float, help="2nd order high-pass corner freq (Hz)")
+    parser.add_argument("--csv", help="target response freq,dB (instead of pink)")
+    parser.add_argument("--speaker", help="measured speaker response freq,dB to correct for")
+    parser.add_argument("--out", help="write the taps to this file, 1 per line (for noise_render -f)")
+    args = parser.parse_args()
+    if not args.taps:
+        args.taps = max(1, min(TAPS_MAX, int((2 * args.divisor * BUDGET / 100 - EST_SAMPLE) / EST_TAP)))
+    if not 1 <= args.taps <= TAPS_MAX:
+        parser.error("taps must be 1 to %d" % TAPS_MAX)
+    if args.csv:
+        args.csv = load(args.csv)
+    if args.speaker:
+        args.speaker = load(args.speaker)
+    rate = 42000000.0 / args.divisor
+
+    h = design(args, rate)
+    if sum(abs(x) for x in h) >= SUM_MAX:
+        raise SystemExit("sum of |taps| is %.1f - must be below %.0f. Try fewer taps or a less steep target" % (sum(abs(x) for x in h), SUM_MAX))
+    q15 = [max(-32768, min(32767, int(round(x * 32768)))) for x in h]
+
+    print("%d taps at %.0f Hz - detail finer than about %.0f Hz can't be followed (ni handles low freq shaping)" % (args.taps, rate, rate / args.taps))
+    cpu = 100 * (EST_SAMPLE + EST_TAP * args.taps) / (2 * args.divisor)
+    print("Estimated CPU load: %.0f%%%s (nf on the Due measures the real figure)" % (cpu, " - too much" if cpu > BUDGET else ""))
+    rows = [] # third octaves: freq, target dB, FIR dB
+    f = 500.0
+    while f < rate * 0.45:
+        rows.append((f, 20 * math.log10(max(target(f, args, 0), 1e-5)), response_db([x / 32768 for x in q15], f, rate)))
+        f *= 2 ** (1 / 3)
+    resolved = [r for r in rows if r[0] >= 2 * rate / args.taps] or rows
+    ref = max(resolved, key=lambda r: r[1]) # both columns 0 dB at the loudest freq the filter can resolve
+    print("\n  Freq (Hz)   Target (dB)   FIR (dB)")
+    for f, t, h in rows:
+        print("  %9.0f   %11.1f   %8.1f" % (f, t - ref[1], h - ref[2]))
+    if args.out:
+        with open(args.out, "w") as out:
+            out.write("\n".join(str(x) for x in q15) + "\n")
+        print("\nTaps written to %s" % args.out)
+    print("\nSerial command:\n%dnf %s" % (args.taps, " ".join(str(x) for x in q15)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+# Speaker compensation design for the noise generator's optional EQ stage (ne over serial)
+#
+# Fits a 2nd order high-pass model (resonance freq f0 & Q0) to a measured speaker response (freq,dB CSV - a real
+# measurement through the amplifier, not a guess from the spec sheet, as the EQ boosts by up to 12 dB), then writes the
+# Linkwitz transform that moves it down to fp (Qp = 0.707) as include/speakereq.h. The boost below f0 is
+# limited to --max-boost dB. noisedsp.h turns these into biquad coefficients at compile time, for the noise
+# sample rate in use. Also prints the predicted response of pink noise at the speaker, with & without the EQ.
+#
+# usage: python3 tools/speakereq.py response.csv [--max-boost dB] [--out include/speakereq.h]
+
+import argparse
+import math
+import os
+
+QP = 0.7071
+
+
+def highpass_db(f, f0, q): # 2nd order high-pass magnitude
+    x = (f / f0) ** 2
+    return 10 * math.log10(x * x / ((1 - x) ** 2 + x / (q * q)))
+
+
+def linkwitz_db(f, f0, q0, fp, qp): # Linkwitz transform, normalised to 0 dB at low freq (high freq gain is (fp/f0)^2)
+    return highpass_db(f, fp, qp) - highpass_db(f, f0, q0) + 40 * math.log10(fp / f0)
+
+
+def load(path):
+    points = []
+    with open(path) as f:
+        for line in f:
+            line = line.split("#")[0].strip()
+            if line:
+                freq, db = line.split(",")
+                points.append((float(freq), float(db)))
+    return points
+
+
+def fit(points): # grid search for the high-pass model with the least squared error (offset fitted too)
+    best = None
+    for i in range(241):
+        f0 = 500 * 10 ** (i / 120.0)
+        for j in range(171):
+            q = 0.3 + j * 0.01
+            err = [db - highpass_db(f, f0, q) for f, db in points]
+            offset = sum(err) / len(err)
+            sq = sum((e - offset) ** 2 for e in err)
+            if best is None or sq < best[0]:
+                best = (sq, f0, q, offset)
+    return best
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser()
+    parser.add_argument("response", help="measured speaker response freq,dB")
+    parser.add_argument("--max-boost", type=float, default=12.0)
+    parser.add_argument("--out", default=os.path.join(here, "..", "include", "speakereq.h"))
+    args = parser.parse_args()
+
+    points = load(args.response)
+    sq, f0, q0, offset = fit(points)
+    fp = f0 / 10 ** (args.max_boost / 40.0)
+    print("Speaker model: f0 %.0f Hz, Q %.2f (RMS fit error %.2f dB)" % (f0, q0, math.sqrt(sq / len(points))))
+    print("Compensated to: fp %.0f Hz, Q %.2f - %.1f dB max boost\n" % (fp, QP, args.max_boost))
+    print("Predicted pink noise at the speaker, relative to the 1/f target (dB):")
+    print("  freq Hz    no EQ      EQ   with EQ")
+    ref = linkwitz_db(20000, f0, q0, fp, QP) # level the curves at 20 kHz
+    f = 500.0
+    while f < 41000:
+        spk = highpass_db(f, f0, q0)
+        eq = linkwitz_db(f, f0, q0, fp, QP) - ref
+        print("  %7.0f  %7.1f  %6.1f  %8.1f" % (f, spk, eq, spk + eq))
+        f *= 2 ** (1 / 3.0)
+
+    with open(args.out, "w") as out:
+        out.write("// Speaker compensation for the noise EQ stage - generated by tools/speakereq.py from %s\n" % os.path.basename(args.response))
+        out.write("// Linkwitz transform: speaker high-pass at SPEAKER_F0 / SPEAKER_Q0 moved down to SPEAKER_FP / SPEAKER_QP\n\n")
+        out.write("#define SPEAKER_F0 %.1f // fitted speaker resonance (Hz)\n" % f0)
+        out.write("#define SPEAKER_Q0 %.3f\n" % q0)
+        out.write("#define SPEAKER_FP %.1f // compensated corner (Hz) - %.1f dB max boost\n" % (fp, args.max_boost))
+        out.write("#define SPEAKER_QP %.4f\n" % QP)
+    print("\nWritten %s" % os.path.normpath(args.out))
+
+
+main()
@@ -0,0 +1,225 @@
+// Host-side THD+N & image measurement for the Due's analogue sine wave - compares the ways it can play a tone
+//
+// Makes the same default sine wave tables as CreateWaveFull() (include/sinetable.h), plays them the way each mode
+// does & measures the output of a zero order hold DAC clocked on the Due's 42 MHz timer ticks:
+//   fast   - FastMode 0 to 3 (160, 80, 40 or 16 samples per cycle, freq stepped by the timer divisor, as freqToTc)
+//   exact  - ExactFreqMode: 400 kHz phase accumulator in TC0_Handler, nearest wave table point
+//   dds    - DDS engine (E over serial) at 42 MHz / DDS_DIVISOR, nearest wave table point
+//   ddshf  - DDS engine above DDS_HF_FREQ: 42 MHz / DDS_HF_DIVISOR, interpolating between wave table points
+// Reports the freq played, THD+N from 20 Hz to the band limit (what an amplifier & speaker pass), harmonics 2 to 5
+// & the worst spur or image above the band up to 2 MHz (what a reconstruction filter must remove), in dB below the
+// tone. Analysis is at 4.2 MHz (10 timer ticks averaged), Blackman-Harris window, 2^20 points (4 Hz bins).
+//
+// build:  g++ -O2 -std=gnu++14 -Iinclude tools/tone_thd.cpp -o tone_thd
+// usage:  ./tone_thd [-f freq Hz] [-m fast|exact|dds|ddshf|all] [-b band Hz] [-d divisor] [-h hf divisor]
+//         hf divisor 42 as DDS_HF_DIVISOR (1 MHz) - down to 26 to compare with the over-rated DDS_OVERRATE rates
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex>
+#include <vector>
+#include "sinetable.h"
+
+#define NWAVEFULL  4096    // these must match src/DueArbitraryWaveformGeneratorV2.cpp
+#define NWAVETABLE 160
+#define WAVERESOL  4096
+#define TICKS      42000000.0 // timer clock (MCK / 2)
+#define DECIMATE   10      // timer ticks averaged per analysis point
+#define FFT_SIZE   1048576
+#define LOBE       6       // bins each side of a peak summed as its power (Blackman-Harris main lobe is 4)
+#define SPUR_MAX   2000000.0
+
+static int16_t WaveFull[NWAVEFULL + 1], WaveFull2[NWAVEFULL + 1], WaveTable[NWAVETABLE], WaveTable2[NWAVETABLE];
+
+static void MakeTables() // default sine, as CreateWaveFull() with SineMix at 100% & CreateWaveTable()
+{
+  for (int i = 0; i < NWAVEFULL; i++)
+  {
+    int32_t v = 2048 + ((SinQ15(0x40000000u + i * 0x80000u) * 2047 + 16384) >> 15); // from the +ve peak, as the Due
+    WaveFull[i]  = v;
+    WaveFull2[i] = WAVERESOL - v < WAVERESOL ? WAVERESOL - v : WAVERESOL - 1;
+  }
+  WaveFull[NWAVEFULL]  = WaveFull2[0];
+  WaveFull2[NWAVEFULL] = WaveFull[0];
+  for (int i = 0; i < NWAVETABLE; i++)
+  {
+    WaveTable[i]  = WaveFull[(int) round(i * (NWAVEFULL / 160.0))];
+    WaveTable2[i] = WaveFull2[(int) round(i * (NWAVEFULL / 160.0))];
+  }
+}
+
+struct Samples // DAC values & the timer ticks between them
+{
+  std::vector<int16_t> v;
+  uint32_t period;
+  double freq;
+};
+
+static Samples PlayFast(double f, int samples) // one cycle of Wave0 to Wave3 at 50% duty, repeated by DMA
+{
+  int fm = f > 40000 ? 3 : f > 20000 ? 2 : f > 10000 ? 1 : 0;
+  int perCycle = fm == 3 ? 16 : 160 >> fm;
+  double k[4] = {42000000.0, 84000000.0, 168000000.0, 420000000.0};
+  Samples s;
+  s.period = (uint32_t) (k[fm] / f / NWAVETABLE); // freqToTc
+  s.freq = k[fm] / s.period / NWAVETABLE;
+  int half = perCycle / 2;
+  float inc = float(NWAVETABLE) / half; // CreateNewWave
+  std::vector<int16_t> cycle;
+  for (int h = 0; h < 2; h++)
+  {
+    float x = 0;
+    for (int i = 0; i < half; i++)
+    {
+      x = fminf(NWAVETABLE - 1, x + inc);
+      cycle.push_back(h ? WaveTable2[(int) roundf(x)] : WaveTable[(int) roundf(x)]);
+    }
+  }
+  for (int i = 0; i < samples; i++) s.v.push_back(cycle[i % perCycle]);
+  return s;
+}
+
+static Samples PlayPhase(double f, uint32_t divisor, bool interpolate, int samples) // phase accumulator at 42 MHz / divisor - 50% duty, each half a full 2^32 sweep
+{
+  Samples s;
+  s.period = divisor;
+  double rate = TICKS / divisor;
+  uint32_t inc = (uint32_t) fmin(4294967295.0, 2 * f * 4294967296.0 / rate + 0.5);
+  s.freq = rate * inc / 2 / 4294967296.0;
+  uint32_t phase = 0;
+  bool half = 0;
+  for (int i = 0; i < samples; i++)
+  {
+    const int16_t *t = half ? WaveFull2 : WaveFull;
+    int32_t v = t[phase >> 20];
+    if (interpolate) v += ((t[(phase >> 20) + 1] - v) * (int32_t) ((phase >> 8) & 0xFFF) + 2048) >> 12;
+    s.v.push_back(v);
+    phase += inc;
+    if (phase < inc) half = !half;
+  }
+  return s;
+}
+
+static void Fft(std::vector<std::complex<double> > &a) // in-place radix 2
+{
+  size_t n = a.size();
+  for (size_t i = 1, j = 0; i < n; i++)
+  {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(a[i], a[j]);
+  }
+  for (size_t len = 2; len <= n; len <<= 1)
+  {
+    std::complex<double> step = std::polar(1.0, -2 * M_PI / len);
+    for (size_t i = 0; i < n; i += len)
+    {
+      std::complex<double> w = 1;
+      for (size_t j = 0; j < len / 2; j++, w *= step)
+      {
+        std::complex<double> u = a[i + j], v = a[i + j + len / 2] * w;
+        a[i + j] = u + v;
+        a[i + j + len / 2] = u - v;
+      }
+    }
+  }
+}
+
+static std::vector<double> Spectrum(const Samples &s) // zero order hold on the timer ticks, averaged to the analysis rate - power per bin
+{
+  std::vector<std::complex<double> > a(FFT_SIZE);
+  size_t sample = 0;
+  uint32_t tick = 0;
+  for (int i = 0; i < FFT_SIZE; i++)
+  {
+    double sum = 0;
+    for (int j = 0; j < DECIMATE; j++)
+    {
+      sum += s.v[sample] - WAVERESOL / 2;
+      if (++tick == s.period) { tick = 0; sample++; }
+    }
+    double x = 2 * M_PI * i / FFT_SIZE;
+    a[i] = sum / DECIMATE * (0.35875 - 0.48829 * cos(x) + 0.14128 * cos(2 * x) - 0.01168 * cos(3 * x)); // Blackman-Harris
+  }
+  Fft(a);
+  std::vector<double> p(FFT_SIZE / 2);
+  for (int i = 0; i < FFT_SIZE / 2; i++) p[i] = std::norm(a[i]);
+  return p;
+}
+
+static double Lobe(const std::vector<double> &p, int bin) // power of the peak near bin
+{
+  double sum = 0;
+  for (int i = std::max(1, bin - LOBE); i <= std::min((int) p.size() - 1, bin + LOBE); i++) sum += p[i];
+  return sum;
+}
+
+static void Measure(const char *name, const Samples &s, double band)
+{
+  std::vector<double> p = Spectrum(s);
+  double binHz = TICKS / DECIMATE / FFT_SIZE;
+  int f0 = (int) round(s.freq / binHz);
+  double fund = Lobe(p, f0);
+  int low = (int) ceil(20 / binHz), high = std::min((int) p.size() - 1, (int) (band / binHz));
+  double noise = 0;
+  for (int i = low; i <= high; i++) if (abs(i - f0) > LOBE) noise += p[i];
+  printf("%-6s %6.0f kHz %12.3f Hz   THD+N %6.1f dB  ", name, TICKS / s.period / 1000, s.freq, 10 * log10(noise / fund));
+  for (int h = 2; h <= 5; h++)
+  {
+    int bin = (int) round(h * s.freq / binHz);
+    if (bin < (int) p.size() && h * s.freq <= band) printf(" %6.1f", 10 * log10(Lobe(p, bin) / fund));
+    else printf("      -");
+  }
+  double worst = 0;
+  int worstBin = 0;
+  for (int i = high + 1; i < std::min((int) p.size() - LOBE, (int) (SPUR_MAX / binHz)); i++)
+    if (abs(i - f0) > LOBE && (!worstBin || p[i] > p[worstBin])) worstBin = i;
+  if (worstBin) worst = Lobe(p, worstBin);
+  if (worstBin) printf("   %6.1f dB at %8.0f Hz\n", 10 * log10(worst / fund), worstBin * binHz);
+  else printf("        -\n");
+}
+
+int main(int argc, char *argv[])
+{
+  double freq = 20000, band = 100000;
+  int divisor = 42, hfDivisor = 42;
+  const char *mode = "all";
+  for (int i = 1; i < argc; i++)
+  {
+    bool more = i + 1 < argc;
+    if (more && !strcmp(argv[i], "-f")) freq = atof(argv[++i]);
+    else if (more && !strcmp(argv[i], "-m")) mode = argv[++i];
+    else if (more && !strcmp(argv[i], "-b")) band = atof(argv[++i]);
+    else if (more && !strcmp(argv[i], "-d")) divisor = atoi(argv[++i]);
+    else if (more && !strcmp(argv[i], "-h")) hfDivisor = atoi(argv[++i]);
+    else
+    {
+      fprintf(stderr, "usage: %s [-f freq Hz] [-m fast|exact|dds|ddshf|all] [-b band Hz] [-d divisor] [-h hf divisor]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (freq < 1000 || freq > 100000 || band <= freq || divisor < 42 || hfDivisor < 26)
+  {
+    fprintf(stderr, "freq must be 1 to 100 kHz, band above freq, divisor 42 or more & hf divisor 26 or more\n");
+    return 2;
+  }
+  MakeTables();
+  int samples = FFT_SIZE * DECIMATE / 25 + 2; // enough for the fastest DAC clock
+  printf("%.0f Hz sine, THD+N from 20 Hz to %.0f Hz, harmonics in dB below the tone\n\n", freq, band);
+  printf("mode   DAC rate   freq played       THD+N       2nd    3rd    4th    5th   worst image / spur above band\n");
+  bool all = !strcmp(mode, "all");
+  bool known = all;
+  if (all || !strcmp(mode, "fast"))  { Measure("fast",  PlayFast(freq, samples), band); known = true; }
+  if (all || !strcmp(mode, "exact")) { Measure("exact", PlayPhase(freq, 105, false, samples), band); known = true; }
+  if (all || !strcmp(mode, "dds"))   { Measure("dds",   PlayPhase(freq, divisor, false, samples), band); known = true; }
+  if (all || !strcmp(mode, "ddshf")) { Measure("ddshf", PlayPhase(freq, hfDivisor, true, samples), band); known = true; }
+  if (!known)
+  {
+    fprintf(stderr, "unknown mode %s\n", mode);
+    return 2;
+  }
+  return 0;
+}